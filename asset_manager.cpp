@@ -0,0 +1,183 @@
+#include "asset_manager.hpp"
+#include "kiosk.hpp"
+#include "rendering.hpp"
+#include "startup_trace.hpp"
+
+#include <algorithm>
+
+asset_manager assets;
+
+namespace
+{
+	void free_decoded(std::future<SDL_Surface *> & job)
+	{
+		try
+		{
+			SDL_FreeSurface(job.get());
+		}
+		catch(std::future_error const &)
+		{
+			// dropped from the queue before it was decoded
+		}
+	}
+}
+
+asset_manager::~asset_manager()
+{
+	// running decodes finish, queued ones are dropped
+	decoders.reset();
+	cancel_all();
+}
+
+void asset_manager::open_bundle(std::filesystem::path const & file)
+{
+	startup_trace::span const span("asset", file.filename().string());
+	if(bundle.open(file))
+		fprintf(stderr, "using resource bundle %s\n", file.c_str());
+}
+
+SDL_Texture * asset_manager::upload(resource_bundle::image const & image) const
+{
+	SDL_Texture * const texture = SDL_CreateTexture(renderer, resource_bundle::format, SDL_TEXTUREACCESS_STATIC, image.w, image.h);
+	if(texture == nullptr)
+		return nullptr;
+	if(SDL_UpdateTexture(texture, nullptr, image.pixels, image.pitch) != 0)
+	{
+		SDL_DestroyTexture(texture);
+		return nullptr;
+	}
+	rendering::context.set_texture_blend_mode(texture, image.alpha ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+	return texture;
+}
+
+SDL_Texture * asset_manager::acquire(void const * owner, std::filesystem::path const & path)
+{
+	auto it = assets.find(path);
+	if(it == assets.end())
+	{
+		if(auto const * image = bundle.find(path))
+		{
+			startup_trace::span const span("asset", path.string());
+			SDL_Texture * const texture = upload(*image);
+			if(texture == nullptr)
+				die("Failed to upload %s: %s", path.c_str(), SDL_GetError());
+
+			it = assets.emplace(path, asset { texture, image->bytes(), { } }).first;
+		}
+	}
+	if(it == assets.end())
+	{
+		startup_trace::span const span("asset", path.string());
+		SDL_Surface * surface;
+		if(auto job = pending.find(path); job != pending.end())
+		{
+			surface = job->second.get();
+			pending.erase(job);
+		}
+		else
+		{
+			surface = IMG_Load((resource_root / path).c_str());
+		}
+		if(surface == nullptr)
+			die("Failed to load %s: %s", path.c_str(), IMG_GetError());
+
+		SDL_Texture * const texture = SDL_CreateTextureFromSurface(renderer, surface);
+		SDL_FreeSurface(surface);
+		if(texture == nullptr)
+			die("Failed to upload %s: %s", path.c_str(), SDL_GetError());
+
+		int w, h;
+		SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+
+		it = assets.emplace(path, asset { texture, 4 * size_t(w) * size_t(h), { } }).first;
+	}
+
+	auto & owners = it->second.owners;
+	if(std::find(owners.begin(), owners.end(), owner) == owners.end())
+		owners.push_back(owner);
+
+	return it->second.texture;
+}
+
+void asset_manager::prefetch(std::filesystem::path const & path)
+{
+	if(assets.count(path) > 0 or pending.count(path) > 0)
+		return;
+
+	if(auto const * image = bundle.find(path))
+	{
+		bundle.prefetch(*image);
+		return;
+	}
+
+	if(not decoders)
+		decoders = std::make_unique<thread_pool>();
+
+	auto const file = resource_root / path;
+	pending.emplace(path, decoders->submit([path, file]() {
+		startup_trace::span const span("decode", path.string());
+		return IMG_Load(file.c_str());
+	}));
+}
+
+void asset_manager::prefetch_directory(std::filesystem::path const & directory)
+{
+	std::error_code error;
+	for(auto const & entry : std::filesystem::directory_iterator(resource_root / directory, error))
+	{
+		if(entry.path().extension() == ".png")
+			prefetch(directory / entry.path().filename());
+	}
+}
+
+void asset_manager::cancel(std::filesystem::path const & path)
+{
+	if(auto job = pending.find(path); job != pending.end())
+	{
+		free_decoded(job->second);
+		pending.erase(job);
+	}
+}
+
+void asset_manager::cancel_all()
+{
+	for(auto & [ path, job ] : pending)
+		free_decoded(job);
+	pending.clear();
+}
+
+void asset_manager::release(void const * owner)
+{
+	for(auto it = assets.begin(); it != assets.end(); /* none */)
+	{
+		auto & owners = it->second.owners;
+		owners.erase(std::remove(owners.begin(), owners.end(), owner), owners.end());
+		if(not owners.empty())
+		{
+			it++;
+			continue;
+		}
+		rendering::context.forget(it->second.texture);
+		SDL_DestroyTexture(it->second.texture);
+		it = assets.erase(it);
+	}
+}
+
+size_t asset_manager::bytes() const
+{
+	size_t sum = 0;
+	for(auto const & [ path, asset ] : assets)
+		sum += asset.bytes;
+	return sum;
+}
+
+size_t asset_manager::bytes(void const * owner) const
+{
+	size_t sum = 0;
+	for(auto const & [ path, asset ] : assets)
+	{
+		if(std::find(asset.owners.begin(), asset.owners.end(), owner) != asset.owners.end())
+			sum += asset.bytes;
+	}
+	return sum;
+}
@@ -0,0 +1,87 @@
+#ifndef ASSET_MANAGER_HPP
+#define ASSET_MANAGER_HPP
+
+#include "thread_pool.hpp"
+#include "resource_bundle.hpp"
+
+#include <SDL.h>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+
+//!
+//! Loads textures from the resource folder and shares them.
+//! Every path is loaded only once, no matter how many owners
+//! acquire it, and is destroyed when the last owner releases it.
+//!
+//! An owner is any address that identifies the user of a texture,
+//! usually the module. nullptr is used for textures that are needed
+//! as long as the kiosk runs.
+//!
+//! Images can be prefetched: they are decoded in parallel on a thread
+//! pool, and only the texture upload in acquire() happens on the
+//! render thread.
+//!
+//! If a resource bundle is opened, images are uploaded from the
+//! bundle instead, and only images missing from it are decoded.
+//!
+struct asset_manager
+{
+	//! frees the images that were prefetched but never acquired.
+	~asset_manager();
+
+	//! uses the resource bundle `file` if it exists.
+	void open_bundle(std::filesystem::path const & file);
+
+	//! returns the texture at `path` relative to the resource root.
+	//! Dies if it can't be loaded.
+	SDL_Texture * acquire(void const * owner, std::filesystem::path const & path);
+
+	//! starts decoding the image at `path` in the background.
+	void prefetch(std::filesystem::path const & path);
+
+	//! prefetches every PNG file in a resource directory.
+	void prefetch_directory(std::filesystem::path const & directory);
+
+	//! frees the prefetched image at `path` if it wasn't acquired,
+	//! waiting for it if it is still being decoded.
+	void cancel(std::filesystem::path const & path);
+
+	//! frees all prefetched images that weren't acquired.
+	void cancel_all();
+
+	//! gives up all textures acquired by `owner`.
+	void release(void const * owner);
+
+	//! texture memory of all loaded assets
+	size_t bytes() const;
+
+	//! texture memory of the assets held by `owner`, shared ones included
+	size_t bytes(void const * owner) const;
+
+private:
+	struct asset
+	{
+		SDL_Texture * texture;
+		size_t bytes;
+		std::vector<void const *> owners;
+	};
+
+	std::map<std::filesystem::path, asset> assets;
+
+	//! images that are being decoded
+	std::map<std::filesystem::path, std::future<SDL_Surface *>> pending;
+
+	resource_bundle bundle;
+
+	SDL_Texture * upload(resource_bundle::image const & image) const;
+
+	//! created with the first prefetch
+	std::unique_ptr<thread_pool> decoders;
+};
+
+extern asset_manager assets;
+
+#endif // ASSET_MANAGER_HPP
@@ -0,0 +1,237 @@
+#include "batch_renderer.hpp"
+#include "kiosk.hpp"
+#include "rendering.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	bool same_color(SDL_Color const & a, SDL_Color const & b)
+	{
+		return (a.r == b.r) and (a.g == b.g) and (a.b == b.b) and (a.a == b.a);
+	}
+
+	SDL_Rect bounds_of(SDL_Point const * points, size_t count)
+	{
+		int x0 = points[0].x, y0 = points[0].y;
+		int x1 = x0, y1 = y0;
+		for(size_t i = 1; i < count; i++)
+		{
+			x0 = std::min(x0, points[i].x);
+			y0 = std::min(y0, points[i].y);
+			x1 = std::max(x1, points[i].x);
+			y1 = std::max(y1, points[i].y);
+		}
+		return { x0, y0, x1 - x0 + 1, y1 - y0 + 1 };
+	}
+}
+
+batch_renderer::batch & batch_renderer::find(kind type, SDL_Texture * texture, SDL_Color const & color, SDL_Rect const & bounds)
+{
+	SDL_BlendMode const blend = (texture != nullptr) ? SDL_BLENDMODE_INVALID : blend_mode;
+
+	auto const matches = [&](batch const & b)
+	{
+		if(b.type != type or b.texture != texture or b.blend != blend)
+			return false;
+		return (type != lines) or same_color(b.color, color);
+	};
+
+	// search backwards for a batch with the same state, but never
+	// move the new command below something it overlaps.
+	for(size_t i = used; i > 0 and (used - i) < max_search_depth; i--)
+	{
+		auto & b = batches[i - 1];
+		if(matches(b))
+		{
+			SDL_UnionRect(&b.bounds, &bounds, &b.bounds);
+			return b;
+		}
+		if(SDL_HasIntersection(&b.bounds, &bounds))
+			break;
+	}
+
+	if(used == batches.size())
+		batches.emplace_back();
+
+	auto & b = batches[used++];
+	b.type = type;
+	b.texture = texture;
+	b.blend = blend;
+	b.color = color;
+	b.bounds = bounds;
+	b.quads.clear();
+	b.points.clear();
+	b.strips.clear();
+	return b;
+}
+
+void batch_renderer::fill_rect(SDL_Rect const & rect, SDL_Color const & color)
+{
+	if(rect.w <= 0 or rect.h <= 0)
+		return;
+	find(geometry, nullptr, color, rect).quads.add_quad(rect, color);
+}
+
+void batch_renderer::draw_rect(SDL_Rect const & rect, SDL_Color const & color)
+{
+	if(rect.w <= 0 or rect.h <= 0)
+		return;
+	auto & quads = find(geometry, nullptr, color, rect).quads;
+	quads.add_quad({ rect.x, rect.y, rect.w, 1 }, color);
+	quads.add_quad({ rect.x, rect.y + rect.h - 1, rect.w, 1 }, color);
+	quads.add_quad({ rect.x, rect.y + 1, 1, rect.h - 2 }, color);
+	quads.add_quad({ rect.x + rect.w - 1, rect.y + 1, 1, rect.h - 2 }, color);
+}
+
+void batch_renderer::draw_line(SDL_Point from, SDL_Point to, SDL_Color const & color)
+{
+	SDL_Point const points[] = { from, to };
+	draw_lines(points, 2, color);
+}
+
+void batch_renderer::draw_lines(SDL_Point const * points, size_t count, SDL_Color const & color)
+{
+	if(count < 2)
+		return;
+	auto & b = find(lines, nullptr, color, bounds_of(points, count));
+	b.points.insert(b.points.end(), points, points + count);
+	b.strips.push_back(b.points.size());
+}
+
+void batch_renderer::copy(SDL_Texture * texture, SDL_Rect const * src, SDL_Rect const & dst, SDL_Color const & tint)
+{
+	if(texture == nullptr or dst.w <= 0 or dst.h <= 0)
+		return;
+
+	SDL_Point size;
+	SDL_QueryTexture(texture, nullptr, nullptr, &size.x, &size.y);
+
+	SDL_Rect const full = { 0, 0, size.x, size.y };
+	find(geometry, texture, tint, dst).quads.add_quad(dst, src ? *src : full, size, tint);
+}
+
+void batch_renderer::copy(SDL_Texture * texture, SDL_FRect const & src, SDL_FRect const & dst, SDL_Color const & tint)
+{
+	if(texture == nullptr or dst.w <= 0 or dst.h <= 0)
+		return;
+
+	SDL_Point size;
+	SDL_QueryTexture(texture, nullptr, nullptr, &size.x, &size.y);
+
+	float const u0 = src.x / size.x;
+	float const v0 = src.y / size.y;
+	float const u1 = (src.x + src.w) / size.x;
+	float const v1 = (src.y + src.h) / size.y;
+
+	SDL_FPoint const pos[4] =
+	{
+		{ dst.x,         dst.y },
+		{ dst.x + dst.w, dst.y },
+		{ dst.x + dst.w, dst.y + dst.h },
+		{ dst.x,         dst.y + dst.h },
+	};
+	SDL_FPoint const uv[4] = { { u0, v0 }, { u1, v0 }, { u1, v1 }, { u0, v1 } };
+
+	SDL_Rect const bounds = {
+		int(std::floor(dst.x)),
+		int(std::floor(dst.y)),
+		int(std::ceil(dst.x + dst.w) - std::floor(dst.x)),
+		int(std::ceil(dst.y + dst.h) - std::floor(dst.y)),
+	};
+
+	find(geometry, texture, tint, bounds).quads.add_quad(pos, uv, tint);
+}
+
+void batch_renderer::copy_ex(SDL_Texture * texture, SDL_Rect const * src, SDL_Rect const & dst, double angle, SDL_Point const * center, SDL_RendererFlip flip, SDL_Color const & tint)
+{
+	if(texture == nullptr or dst.w <= 0 or dst.h <= 0)
+		return;
+
+	SDL_Point size;
+	SDL_QueryTexture(texture, nullptr, nullptr, &size.x, &size.y);
+
+	SDL_Rect const s = src ? *src : SDL_Rect { 0, 0, size.x, size.y };
+	float u0 = float(s.x) / size.x;
+	float v0 = float(s.y) / size.y;
+	float u1 = float(s.x + s.w) / size.x;
+	float v1 = float(s.y + s.h) / size.y;
+	if(flip & SDL_FLIP_HORIZONTAL)
+		std::swap(u0, u1);
+	if(flip & SDL_FLIP_VERTICAL)
+		std::swap(v0, v1);
+
+	SDL_FPoint const pivot = center
+		? SDL_FPoint { float(dst.x + center->x), float(dst.y + center->y) }
+		: SDL_FPoint { dst.x + dst.w / 2.0f, dst.y + dst.h / 2.0f };
+
+	float const rad = float(angle * M_PI / 180.0);
+	float const c = std::cos(rad);
+	float const sn = std::sin(rad);
+
+	auto const rotate = [&](float x, float y) -> SDL_FPoint
+	{
+		x -= pivot.x;
+		y -= pivot.y;
+		return { pivot.x + c * x - sn * y, pivot.y + sn * x + c * y };
+	};
+
+	SDL_FPoint const pos[4] =
+	{
+		rotate(dst.x,         dst.y),
+		rotate(dst.x + dst.w, dst.y),
+		rotate(dst.x + dst.w, dst.y + dst.h),
+		rotate(dst.x,         dst.y + dst.h),
+	};
+	SDL_FPoint const uv[4] = { { u0, v0 }, { u1, v0 }, { u1, v1 }, { u0, v1 } };
+
+	float x0 = pos[0].x, y0 = pos[0].y, x1 = x0, y1 = y0;
+	for(auto const & p : pos)
+	{
+		x0 = std::min(x0, p.x);
+		y0 = std::min(y0, p.y);
+		x1 = std::max(x1, p.x);
+		y1 = std::max(y1, p.y);
+	}
+	SDL_Rect const bounds = {
+		int(std::floor(x0)),
+		int(std::floor(y0)),
+		int(std::ceil(x1 - std::floor(x0))) + 1,
+		int(std::ceil(y1 - std::floor(y0))) + 1,
+	};
+
+	find(geometry, texture, tint, bounds).quads.add_quad(pos, uv, tint);
+}
+
+void batch_renderer::flush()
+{
+	for(size_t i = 0; i < used; i++)
+	{
+		auto const & b = batches[i];
+		switch(b.type)
+		{
+			case geometry:
+				if(b.texture == nullptr)
+					rendering::context.set_draw_blend_mode(b.blend);
+				b.quads.draw(renderer, b.texture);
+				draw_calls += 1;
+				break;
+
+			case lines:
+			{
+				rendering::context.set_draw_blend_mode(b.blend);
+				rendering::context.set_draw_color(b.color);
+				size_t start = 0;
+				for(auto const end : b.strips)
+				{
+					SDL_RenderDrawLines(renderer, &b.points[start], int(end - start));
+					start = end;
+					draw_calls += 1;
+				}
+				break;
+			}
+		}
+	}
+	used = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef BATCH_RENDERER_HPP
+#define BATCH_RENDERER_HPP
+
+#include "mesh.hpp"
+
+#include <SDL.h>
+#include <vector>
+
+//!
+//! Collects rects, lines and textured quads of a frame and
+//! draws them with as few SDL calls as possible.
+//!
+//! Commands with the same state (texture and blend mode) are
+//! merged into one SDL_RenderGeometry call. A command may be moved
+//! to an earlier batch with the same state as long as it does not
+//! overlap anything drawn in between, so the result always looks
+//! like the commands were drawn in order.
+//!
+//! Must be flushed before the clip rect or the render target changes.
+//!
+struct batch_renderer
+{
+	//! how many batches are searched backwards for a matching state
+	static size_t constexpr max_search_depth = 16;
+
+	//! blend mode for untextured primitives
+	SDL_BlendMode blend_mode = SDL_BLENDMODE_BLEND;
+
+	void set_blend_mode(SDL_BlendMode mode) {
+		blend_mode = mode;
+	}
+
+	void fill_rect(SDL_Rect const & rect, SDL_Color const & color);
+
+	//! draws a one pixel wide outline inside of `rect`.
+	void draw_rect(SDL_Rect const & rect, SDL_Color const & color);
+
+	void draw_line(SDL_Point from, SDL_Point to, SDL_Color const & color);
+
+	//! draws a connected line through all `count` points.
+	void draw_lines(SDL_Point const * points, size_t count, SDL_Color const & color);
+
+	//! draws the texels `src` (or the whole texture) of `texture` into `dst`.
+	void copy(SDL_Texture * texture, SDL_Rect const * src, SDL_Rect const & dst, SDL_Color const & tint = { 0xFF, 0xFF, 0xFF, 0xFF });
+
+	//! same as copy, but with subpixel precision for scaled and moving quads.
+	void copy(SDL_Texture * texture, SDL_FRect const & src, SDL_FRect const & dst, SDL_Color const & tint = { 0xFF, 0xFF, 0xFF, 0xFF });
+
+	//! same as copy, but rotates `angle` degrees clockwise around `center`
+	//! (relative to dst, nullptr is the center of dst) and flips the texture.
+	void copy_ex(SDL_Texture * texture, SDL_Rect const * src, SDL_Rect const & dst, double angle, SDL_Point const * center, SDL_RendererFlip flip, SDL_Color const & tint = { 0xFF, 0xFF, 0xFF, 0xFF });
+
+	//! draws all collected commands.
+	void flush();
+
+	//! number of SDL draw calls issued, reset by the user.
+	size_t draw_calls = 0;
+
+private:
+	enum kind { geometry, lines };
+
+	struct batch
+	{
+		kind type;
+		SDL_Texture * texture;
+		SDL_BlendMode blend;
+		SDL_Color color; // only for lines
+		SDL_Rect bounds;
+
+		mesh quads;
+		std::vector<SDL_Point> points;
+		std::vector<size_t> strips; // end of each line strip in points
+	};
+
+	//! batches are reused between frames to keep their storage.
+	std::vector<batch> batches;
+	size_t used = 0;
+
+	batch & find(kind type, SDL_Texture * texture, SDL_Color const & color, SDL_Rect const & bounds);
+};
+
+#endif // BATCH_RENDERER_HPP
@@ -0,0 +1,91 @@
+#include "damage_tracker.hpp"
+#include "kiosk.hpp"
+#include "rendering.hpp"
+
+#include <optional>
+
+damage_tracker damage;
+
+static std::optional<SDL_Rect> redraw_region;
+
+void damage_tracker::add()
+{
+	everything = true;
+	regions.clear();
+}
+
+void damage_tracker::add(SDL_Rect const & region)
+{
+	if(everything)
+		return;
+
+	SDL_Rect const screen = { 0, 0, screen_size.x, screen_size.y };
+
+	SDL_Rect rect;
+	if(not SDL_IntersectRect(&region, &screen, &rect))
+		return;
+
+	// merge with all regions the new one touches, until nothing overlaps anymore
+	for(auto it = regions.begin(); it != regions.end(); /* none */)
+	{
+		if(SDL_HasIntersection(&*it, &rect))
+		{
+			SDL_UnionRect(&*it, &rect, &rect);
+			regions.erase(it);
+			it = regions.begin();
+		}
+		else
+		{
+			it++;
+		}
+	}
+
+	if(regions.size() >= max_regions)
+	{
+		for(auto const & r : regions)
+			SDL_UnionRect(&r, &rect, &rect);
+		regions.clear();
+	}
+
+	regions.push_back(rect);
+}
+
+void damage_tracker::clear()
+{
+	everything = false;
+	regions.clear();
+}
+
+void set_redraw_region(SDL_Rect const * region)
+{
+	rendering::batch.flush();
+	if(region != nullptr)
+		redraw_region = *region;
+	else
+		redraw_region.reset();
+	rendering::context.set_clip_rect(region);
+}
+
+void set_clip_rect(SDL_Rect const * rect)
+{
+	rendering::batch.flush();
+	if(not redraw_region)
+	{
+		rendering::context.set_clip_rect(rect);
+		return;
+	}
+	if(rect == nullptr)
+	{
+		rendering::context.set_clip_rect(&*redraw_region);
+		return;
+	}
+
+	SDL_Rect clipped;
+	if(not SDL_IntersectRect(rect, &*redraw_region, &clipped))
+	{
+		// an empty clip rect would disable clipping, so clip
+		// to a single pixel outside of the render target instead.
+		clipped = { -1, -1, 1, 1 };
+	}
+	rendering::context.set_clip_rect(&clipped);
+}
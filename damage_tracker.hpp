@@ -0,0 +1,43 @@
+#ifndef DAMAGE_TRACKER_HPP
+#define DAMAGE_TRACKER_HPP
+
+#include <SDL.h>
+#include <vector>
+
+//!
+//! Collects the regions of the screen that have
+//! changed and must be redrawn in the next frame.
+//!
+struct damage_tracker
+{
+	//! when there are more regions than this, they are merged into one.
+	static size_t constexpr max_regions = 8;
+
+	std::vector<SDL_Rect> regions;
+	bool everything = false;
+
+	//! marks the whole screen as damaged.
+	void add();
+
+	//! marks the given region of the screen as damaged.
+	void add(SDL_Rect const & region);
+
+	bool empty() const {
+		return not everything and regions.empty();
+	}
+
+	void clear();
+};
+
+extern damage_tracker damage;
+
+//! Restricts all drawing to the given region of the render target
+//! until it is reset with nullptr. Used by the frame composer.
+void set_redraw_region(SDL_Rect const * region);
+
+//! Sets the clip rectangle of the renderer while keeping all drawing
+//! inside the region that is currently redrawn.
+//! Passing nullptr removes the clip rectangle.
+void set_clip_rect(SDL_Rect const * rect);
+
+#endif // DAMAGE_TRACKER_HPP
@@ -0,0 +1,263 @@
+#include "font_manager.hpp"
+#include "kiosk.hpp"
+#include "rendering.hpp"
+#include "startup_trace.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	//! layout of the glyph cache files
+	struct cache_header
+	{
+		char magic[4];
+		Uint32 version;
+		Uint64 font_hash;
+		Sint32 size;
+		Uint32 glyph_count;
+	};
+
+	//! followed by w * h ARGB8888 texels
+	struct cache_glyph
+	{
+		Uint32 codepoint;
+		Sint32 offset, advance;
+		Sint32 w, h;
+	};
+
+	char constexpr cache_magic[4] = { 'K', 'G', 'L', 'Y' };
+	Uint32 constexpr cache_version = 1;
+
+	Uint64 fnv1a(void const * data, size_t length)
+	{
+		Uint64 hash = 0xcbf29ce484222325;
+		for(size_t i = 0; i < length; i++)
+		{
+			hash ^= static_cast<Uint8 const *>(data)[i];
+			hash *= 0x100000001b3;
+		}
+		return hash;
+	}
+}
+
+void font_manager::open(std::filesystem::path const & file)
+{
+	startup_trace::span const span("font", file.filename().string());
+
+	int const fd = ::open(file.c_str(), O_RDONLY);
+	if(fd < 0)
+		die("Failed to open %s: %s", file.c_str(), strerror(errno));
+
+	struct stat info;
+	if(fstat(fd, &info) < 0)
+		die("Failed to stat %s: %s", file.c_str(), strerror(errno));
+
+	void * const mapping = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	if(mapping == MAP_FAILED)
+		die("Failed to map %s: %s", file.c_str(), strerror(errno));
+	::close(fd);
+
+	this->file = file;
+	this->data = mapping;
+	this->length = size_t(info.st_size);
+	this->hash = fnv1a(data, length);
+}
+
+TTF_Font * font_manager::open_size(int size) const
+{
+	if(data == nullptr)
+		die("No font file opened");
+
+	// the RWops is freed by SDL_ttf together with the font
+	TTF_Font * const font = TTF_OpenFontRW(SDL_RWFromConstMem(data, int(length)), 1, size);
+	if(font == nullptr)
+		die("Failed to open %s in size %d: %s", file.c_str(), size, TTF_GetError());
+	return font;
+}
+
+FontRenderer & font_manager::get(int size)
+{
+	auto & font = sizes[size];
+	if(not font)
+	{
+		startup_trace::span const span("font", "size " + std::to_string(size));
+
+		// the second instance rasterizes in the background
+		font = std::make_unique<FontRenderer>(renderer, open_size(size), open_size(size));
+		load_glyphs(size, *font);
+	}
+	return *font;
+}
+
+std::filesystem::path font_manager::cache_file(int size) const
+{
+	auto const root = cache_directory();
+	if(root.empty())
+		return { };
+
+	char name[64];
+	snprintf(name, sizeof name, "glyphs-%016llx-%d.bin", static_cast<unsigned long long>(hash), size);
+	return root / name;
+}
+
+void font_manager::load_glyphs(int size, FontRenderer & font) const
+{
+	auto const path = cache_file(size);
+	if(path.empty())
+		return;
+
+	int const fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return; // not cached yet
+
+	struct stat info;
+	if(fstat(fd, &info) < 0 or size_t(info.st_size) < sizeof(cache_header))
+	{
+		::close(fd);
+		return;
+	}
+	size_t const file_length = size_t(info.st_size);
+
+	void * const mapping = mmap(nullptr, file_length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if(mapping == MAP_FAILED)
+		return;
+
+	auto const * pos = static_cast<Uint8 const *>(mapping);
+	auto const * const end = pos + file_length;
+
+	cache_header header;
+	std::memcpy(&header, pos, sizeof header);
+	pos += sizeof header;
+
+	bool const valid = (std::memcmp(header.magic, cache_magic, sizeof cache_magic) == 0)
+		and (header.version == cache_version)
+		and (header.font_hash == hash)
+		and (header.size == size);
+
+	for(Uint32 i = 0; valid and i < header.glyph_count; i++)
+	{
+		cache_glyph glyph;
+		if(size_t(end - pos) < sizeof glyph)
+			break;
+		std::memcpy(&glyph, pos, sizeof glyph);
+		pos += sizeof glyph;
+
+		size_t const texels = 4 * size_t(glyph.w) * size_t(glyph.h);
+		if(glyph.w < 0 or glyph.h < 0 or size_t(end - pos) < texels)
+			break;
+
+		FontRenderer::Glyph loaded { { 0, 0, 0, 0 }, glyph.offset, glyph.advance };
+		if(texels > 0)
+		{
+			std::unique_ptr<SDL_Surface, decltype(&SDL_FreeSurface)> surface {
+				SDL_CreateRGBSurfaceWithFormatFrom(
+					const_cast<Uint8 *>(pos),
+					glyph.w, glyph.h,
+					32, 4 * glyph.w,
+					SDL_PIXELFORMAT_ARGB8888
+				),
+				SDL_FreeSurface
+			};
+			if(not surface)
+				break;
+			auto const rect = rendering::atlas.insert(surface.get());
+			if(not rect)
+				break;
+			loaded.src = *rect;
+		}
+		pos += texels;
+
+		font.glyphs.emplace(glyph.codepoint, loaded);
+	}
+
+	// everything is in the atlas now
+	munmap(mapping, file_length);
+
+	font.saved_glyphs = font.glyphs.size();
+}
+
+void font_manager::save_glyphs(int size, FontRenderer const & font) const
+{
+	if(font.glyphs.size() == font.saved_glyphs)
+		return;
+
+	auto const path = cache_file(size);
+	if(path.empty())
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	// write to a temporary file, so an interrupted save never leaves a broken cache
+	auto const temp = std::filesystem::path(path).concat(".tmp");
+	FILE * const f = fopen(temp.c_str(), "wb");
+	if(f == nullptr)
+	{
+		fprintf(stderr, "failed to write glyph cache %s: %s\n", temp.c_str(), strerror(errno));
+		return;
+	}
+
+	cache_header header;
+	std::memcpy(header.magic, cache_magic, sizeof cache_magic);
+	header.version = cache_version;
+	header.font_hash = hash;
+	header.size = size;
+	header.glyph_count = Uint32(font.glyphs.size());
+	bool ok = (fwrite(&header, sizeof header, 1, f) == 1);
+
+	std::vector<Uint32> texels;
+	for(auto const & [ codepoint, glyph ] : font.glyphs)
+	{
+		cache_glyph const record { codepoint, glyph.offset, glyph.advance, glyph.src.w, glyph.src.h };
+		ok = ok and (fwrite(&record, sizeof record, 1, f) == 1);
+
+		texels.resize(size_t(glyph.src.w) * size_t(glyph.src.h));
+		if(texels.empty())
+			continue;
+		rendering::atlas.read(glyph.src, texels.data());
+		ok = ok and (fwrite(texels.data(), sizeof(Uint32), texels.size(), f) == texels.size());
+	}
+
+	ok = (fclose(f) == 0) and ok;
+	if(ok)
+		std::filesystem::rename(temp, path, error);
+	if(not ok or error)
+	{
+		fprintf(stderr, "failed to write glyph cache %s\n", path.c_str());
+		std::filesystem::remove(temp, error);
+		return;
+	}
+
+	font.saved_glyphs = font.glyphs.size();
+}
+
+void font_manager::save_glyphs() const
+{
+	for(auto const & [ size, font ] : sizes)
+		save_glyphs(size, *font);
+}
+
+void font_manager::collect_garbage()
+{
+	for(auto & [ size, font ] : sizes)
+		font->collect_garbage();
+}
+
+void font_manager::close()
+{
+	save_glyphs();
+	sizes.clear();
+	if(data != nullptr)
+		munmap(const_cast<void *>(data), length);
+	data = nullptr;
+	length = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef FONT_MANAGER_HPP
+#define FONT_MANAGER_HPP
+
+#include "fontrenderer.hpp"
+
+#include <filesystem>
+#include <map>
+#include <memory>
+
+//!
+//! Serves a font file in any size. The file is mapped into
+//! memory once and every size is opened from that mapping,
+//! while all sizes share the glyph atlas.
+//!
+//! The rasterized glyphs of each size are kept in a cache file
+//! that is loaded into the atlas when the size is opened, so known
+//! text doesn't need any work from SDL_ttf after a restart.
+//!
+struct font_manager
+{
+	//! maps the font file, dies if it can't be read.
+	void open(std::filesystem::path const & file);
+
+	//! point size whose glyphs are drawn scaled to any other size
+	static int constexpr scalable_size = 64;
+
+	//! returns the renderer for a point size and opens it on first use.
+	FontRenderer & get(int size);
+
+	//! returns the font to use with FontRenderer::render_scaled.
+	FontRenderer & scalable() {
+		return get(scalable_size);
+	}
+
+	//! ends the frame for all sizes.
+	void collect_garbage();
+
+	//! saves the glyphs, closes all sizes and unmaps the font file.
+	void close();
+
+	//! writes the glyphs of all sizes to their cache files.
+	void save_glyphs() const;
+
+	std::map<int, std::unique_ptr<FontRenderer>> sizes;
+
+private:
+	std::filesystem::path file;
+	void const * data = nullptr;
+	size_t length = 0;
+	Uint64 hash = 0; // identifies the font in the cache files
+
+	TTF_Font * open_size(int size) const;
+
+	//! $XDG_CACHE_HOME/shack-kiosk/glyphs-<hash>-<size>.bin
+	std::filesystem::path cache_file(int size) const;
+
+	void load_glyphs(int size, FontRenderer & font) const;
+
+	void save_glyphs(int size, FontRenderer const & font) const;
+};
+
+#endif // FONT_MANAGER_HPP
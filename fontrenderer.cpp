@@ -1,52 +1,626 @@
 #include "fontrenderer.hpp"
-#include <cassert>
+#include "kiosk.hpp"
+#include "rendering.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 
-FontRenderer::FontRenderer(SDL_Renderer * renderer, TTF_Font * font) :
+namespace
+{
+	char constexpr ellipsis[] = "\u2026";
+	size_t constexpr ellipsis_length = sizeof(ellipsis) - 1;
+
+	//! true for the first byte of an UTF-8 sequence
+	bool is_lead_byte(char c)
+	{
+		return (Uint8(c) & 0xC0) != 0x80;
+	}
+
+	//! decodes the UTF-8 sequence at `pos` and advances `pos` behind it.
+	Uint32 next_codepoint(std::string_view str, size_t & pos)
+	{
+		auto const byte = [&](size_t i) -> Uint32 {
+			return (pos + i < str.size()) ? (Uint8(str[pos + i]) & 0x3F) : 0;
+		};
+
+		Uint32 const lead = Uint8(str[pos]);
+		Uint32 codepoint;
+		if(lead < 0x80)
+		{
+			codepoint = lead;
+			pos += 1;
+		}
+		else if((lead & 0xE0) == 0xC0)
+		{
+			codepoint = ((lead & 0x1F) << 6) | byte(1);
+			pos += 2;
+		}
+		else if((lead & 0xF0) == 0xE0)
+		{
+			codepoint = ((lead & 0x0F) << 12) | (byte(1) << 6) | byte(2);
+			pos += 3;
+		}
+		else if((lead & 0xF8) == 0xF0)
+		{
+			codepoint = ((lead & 0x07) << 18) | (byte(1) << 12) | (byte(2) << 6) | byte(3);
+			pos += 4;
+		}
+		else
+		{
+			codepoint = 0xFFFD;
+			pos += 1;
+		}
+		return codepoint;
+	}
+}
+
+//! Rasterizes strings with its own font instance on a background thread.
+struct FontRenderer::Worker
+{
+	struct Job
+	{
+		std::string text;
+		size_t hash;
+		SDL_Rect target; // where the text is shown
+	};
+
+	struct Result
+	{
+		std::string text;
+		size_t hash;
+		SDL_Surface * surface;
+	};
+
+	std::unique_ptr<TTF_Font, decltype(&TTF_CloseFont)> font;
+
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	std::deque<Job> jobs;
+	std::vector<Result> results;
+	bool stop = false;
+
+	//! where the finished texts of the current batch are shown
+	SDL_Rect damaged;
+	bool has_damage = false;
+
+	//! lets the render thread skip the lock when nothing is done
+	std::atomic_bool has_results = false;
+
+	//! hashes of strings that are queued or in progress, render thread only
+	std::unordered_set<size_t> pending;
+
+	std::thread thread;
+
+	explicit Worker(TTF_Font * font) :
+		font { font, TTF_CloseFont },
+		thread { &Worker::run, this }
+	{
+
+	}
+
+	~Worker()
+	{
+		{
+			std::lock_guard<std::mutex> lock { mutex };
+			stop = true;
+		}
+		wakeup.notify_one();
+		thread.join();
+
+		for(auto const & result : results)
+			SDL_FreeSurface(result.surface);
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock { mutex };
+		while(true)
+		{
+			wakeup.wait(lock, [this] { return stop or not jobs.empty(); });
+			if(stop)
+				return;
+
+			Job job = std::move(jobs.front());
+			jobs.pop_front();
+
+			lock.unlock();
+			SDL_Surface * const surface = TTF_RenderUTF8_Blended(
+				font.get(),
+				job.text.empty() ? " " : job.text.c_str(),
+				{ 0xFF, 0xFF, 0xFF, 0xFF }
+			);
+			lock.lock();
+
+			results.push_back(Result { std::move(job.text), job.hash, surface });
+			has_results = true;
+
+			if(has_damage)
+				SDL_UnionRect(&damaged, &job.target, &damaged);
+			else
+				damaged = job.target;
+			has_damage = true;
+
+			// the frame that picks up the texts has to be drawn,
+			// once for all strings that were queued together
+			if(jobs.empty())
+			{
+				request_redraw(damaged);
+				has_damage = false;
+			}
+		}
+	}
+};
+
+FontRenderer::FontRenderer(SDL_Renderer * renderer, TTF_Font * font, TTF_Font * worker_font, size_t cache_budget) :
   renderer{ renderer },
   font { font, TTF_CloseFont },
   cache { },
-  generation { 0 }
+  cache_index { },
+  cache_bytes { 0 },
+  cache_budget { cache_budget },
+  generation { 0 },
+  worker { worker_font ? std::make_unique<Worker>(worker_font) : nullptr }
 {
 
 }
 
-FontRenderer::Text const & FontRenderer::render(const std::string & what) const
+FontRenderer::~FontRenderer() = default;
+
+FontRenderer::Text * FontRenderer::find(std::string_view what, size_t hash) const
+{
+	auto it = cache_index.find(hash);
+	if(it == cache_index.end())
+		return nullptr;
+
+	auto const text = it->second;
+	if(text->key == what)
+	{
+		cache_stats.hits += 1;
+		text->last_use = generation;
+		cache.splice(cache.begin(), cache, text);
+		return &*text;
+	}
+
+	// hash collision, the older string makes room
+	cache_bytes -= text->bytes();
+	retired.push_back(std::move(text->texture));
+	cache.erase(text);
+	cache_index.erase(it);
+	return nullptr;
+}
+
+FontRenderer::Text & FontRenderer::insert(std::string_view what, size_t hash, SDL_Surface * surface) const
+{
+	cache_stats.misses += 1;
+
+	std::unique_ptr<SDL_Surface, decltype(&SDL_FreeSurface)> owner { surface, SDL_FreeSurface };
+
+	// a string SDL_ttf fails to render is cached without a texture,
+	// so it is drawn as nothing instead of being retried every frame.
+	TexturePtr texture { nullptr, SDL_DestroyTexture };
+	if(surface != nullptr)
+		texture.reset(SDL_CreateTextureFromSurface(renderer, surface));
+
+	int const width = texture ? surface->w : 0;
+	int const height = texture ? surface->h : 0;
+
+	auto & text = cache.emplace_front(std::move(texture));
+	text.width = width;
+	text.height = height;
+	text.key = what;
+	text.hash = hash;
+	text.last_use = generation;
+	cache_index.emplace(hash, cache.begin());
+	cache_bytes += text.bytes();
+
+	evict();
+	return text;
+}
+
+void FontRenderer::receive() const
+{
+	if(not worker or not worker->has_results)
+		return;
+
+	std::vector<Worker::Result> results;
+	{
+		std::lock_guard<std::mutex> lock { worker->mutex };
+		results.swap(worker->results);
+		worker->has_results = false;
+	}
+
+	for(auto & result : results)
+	{
+		worker->pending.erase(result.hash);
+		if(cache_index.count(result.hash) > 0)
+		{
+			// rendered in place in the meantime
+			SDL_FreeSurface(result.surface);
+			continue;
+		}
+		insert(result.text, result.hash, result.surface);
+	}
+}
+
+FontRenderer::Text const & FontRenderer::render(std::string_view what) const
 {
-	auto str = what.empty() ? " " : what;
-	if(auto it = cache.find(what); it != cache.end())
+	auto const hash = std::hash<std::string_view>{}(what);
+	if(auto text = find(what, hash))
+		return *text;
+
+	// SDL_ttf needs a terminated string
+	std::string const str { what.empty() ? std::string_view(" ") : what };
+
+	return insert(what, hash, TTF_RenderUTF8_Blended(font.get(), str.c_str(), { 0xFF, 0xFF, 0xFF, 0xFF }));
+}
+
+void FontRenderer::evict() const
+{
+	while(cache_bytes > cache_budget and not cache.empty())
+	{
+		auto const & oldest = cache.back();
+		if(oldest.last_use == generation)
+			break;
+		cache_bytes -= oldest.bytes();
+		cache_index.erase(oldest.hash);
+		cache.pop_back();
+		cache_stats.evictions += 1;
+	}
+}
+
+FontRenderer::Glyph const * FontRenderer::glyph(Uint32 codepoint) const
+{
+	if(auto it = glyphs.find(codepoint); it != glyphs.end())
+		return &it->second;
+	if(atlas_rejects.count(codepoint) > 0)
+		return nullptr;
+
+	Glyph glyph { { 0, 0, 0, 0 }, 0, 0 };
+
+	int minx, maxx, miny, maxy;
+	if(TTF_GlyphMetrics32(font.get(), codepoint, &minx, &maxx, &miny, &maxy, &glyph.advance) < 0)
+		glyph.advance = 0;
+
+	// the bitmap starts left of the pen when the glyph overhangs
+	glyph.offset = std::min(0, minx);
+
+	std::unique_ptr<SDL_Surface, decltype(&SDL_FreeSurface)> surface {
+		TTF_RenderGlyph32_Blended(font.get(), codepoint, { 0xFF, 0xFF, 0xFF, 0xFF }),
+		SDL_FreeSurface
+	};
+	if(surface and surface->w > 0 and surface->h > 0)
 	{
-		if(it->second.last_use != generation)
+		auto const rect = rendering::atlas.insert(surface.get());
+		if(not rect)
 		{
-			it->second.ttl ++;
-			it->second.last_use = generation;
+			// the atlas only fills up, so don't rasterize it again
+			atlas_rejects.insert(codepoint);
+			return nullptr;
 		}
-		return it->second;
+		glyph.src = *rect;
 	}
+
+	return &glyphs.emplace(codepoint, glyph).first->second;
+}
+
+bool FontRenderer::layout_width(std::string_view what, int & width) const
+{
+	width = 0;
+	int pen = 0;
+	Uint32 previous = 0;
+	for(size_t pos = 0; pos < what.size(); )
+	{
+		Uint32 const codepoint = next_codepoint(what, pos);
+		auto const g = glyph(codepoint);
+		if(g == nullptr)
+			return false;
+		if(previous != 0)
+			pen += TTF_GetFontKerningSizeGlyphs32(font.get(), previous, codepoint);
+		width = std::max({ width, pen + g->advance, pen + g->offset + g->src.w });
+		pen += g->advance;
+		previous = codepoint;
+	}
+	return true;
+}
+
+bool FontRenderer::render_glyphs(SDL_Rect const & target, std::string_view what, int align, SDL_Color const & color) const
+{
+	// measure first, so a full atlas can still fall back to a string texture
+	int width;
+	if(not layout_width(what, width))
+		return false;
+
+	int const text_height = height();
+
+	SDL_Rect dst;
+	dst.w = std::min(width, target.w);
+	dst.h = std::min(text_height, target.h);
+
+	if(align & Right)
+		dst.x = target.x + target.w - dst.w;
+	else if(align & Center)
+		dst.x = target.x + (target.w - dst.w) / 2;
 	else
+		dst.x = target.x;
+
+	if(align & Bottom)
+		dst.y = target.y + target.h - dst.h;
+	else if(align & Middle)
+		dst.y = target.y + (target.h - dst.h) / 2;
+	else
+		dst.y = target.y;
+
+	// text that doesn't fit is cropped around its center
+	SDL_Point const origin = {
+		dst.x - (width - dst.w) / 2,
+		dst.y - (text_height - dst.h) / 2,
+	};
+
+	int pen = 0;
+	Uint32 previous = 0;
+	for(size_t pos = 0; pos < what.size(); )
 	{
-		std::unique_ptr<SDL_Surface, decltype(&SDL_FreeSurface)> surface {
-			TTF_RenderUTF8_Blended(font.get(), str.c_str(), { 0xFF, 0xFF, 0xFF, 0xFF }),
-			SDL_FreeSurface
-		};
-		assert(surface);
+		Uint32 const codepoint = next_codepoint(what, pos);
+		auto const & g = glyphs.at(codepoint);
+		if(previous != 0)
+			pen += TTF_GetFontKerningSizeGlyphs32(font.get(), previous, codepoint);
+
+		SDL_Rect const quad = { origin.x + pen + g.offset, origin.y, g.src.w, g.src.h };
+		SDL_Rect visible;
+		if(g.src.w > 0 and SDL_IntersectRect(&quad, &dst, &visible))
+		{
+			SDL_Rect const src = {
+				g.src.x + (visible.x - quad.x),
+				g.src.y + (visible.y - quad.y),
+				visible.w,
+				visible.h
+			};
+			rendering::batch.copy(rendering::atlas.texture, &src, visible, color);
+		}
+
+		pen += g.advance;
+		previous = codepoint;
+	}
+	return true;
+}
+
+SDL_Point FontRenderer::measure(std::string_view what) const
+{
+	auto const hash = std::hash<std::string_view>{}(what);
+	if(auto it = measurements.find(hash); it != measurements.end() and it->second.key == what)
+		return it->second.size;
+
+	// SDL_ttf needs a terminated string
+	std::string key { what };
+
+	SDL_Point size = { 0, 0 };
+	if(TTF_SizeUTF8(font.get(), key.c_str(), &size.x, &size.y) < 0)
+		size = { 0, height() };
 
-		std::unique_ptr<SDL_Texture, decltype(&SDL_DestroyTexture)> texture {
-			SDL_CreateTextureFromSurface(renderer, surface.get() ) ,
-			SDL_DestroyTexture
+	if(measurements.size() >= max_measurements)
+		measurements.clear();
+	measurements[hash] = Measurement { std::move(key), size };
+	return size;
+}
+
+size_t FontRenderer::fit(std::string_view what, int width, bool with_ellipsis) const
+{
+	char buffer[format_buffer_size];
+
+	auto const width_of = [&](size_t length) -> int
+	{
+		if(not with_ellipsis)
+			return measure(what.substr(0, length)).x;
+		std::memcpy(buffer, what.data(), length);
+		std::memcpy(buffer + length, ellipsis, ellipsis_length);
+		return measure(std::string_view(buffer, length + ellipsis_length)).x;
+	};
+
+	auto const is_boundary = [&](size_t pos) {
+		return (pos >= what.size()) or is_lead_byte(what[pos]);
+	};
+
+	// binary search for the longest prefix that fits
+	size_t low = 0;
+	size_t high = std::min(what.size(), sizeof buffer - ellipsis_length);
+	while(high > 0 and not is_boundary(high))
+		high -= 1;
+	while(low < high)
+	{
+		size_t mid = (low + high + 1) / 2;
+		while(mid > low + 1 and not is_boundary(mid))
+			mid -= 1;
+		while(mid < high and not is_boundary(mid))
+			mid += 1;
+
+		if(width_of(mid) <= width)
+		{
+			low = mid;
+		}
+		else
+		{
+			high = mid - 1;
+			while(high > low and not is_boundary(high))
+				high -= 1;
+		}
+	}
+	return low;
+}
+
+void FontRenderer::render_scaled(SDL_Rect const & target, std::string_view what, float size, int align, SDL_Color const & color) const
+{
+	int width;
+	if(size <= 0 or not layout_width(what, width))
+		return;
+
+	float const scale = size / float(height());
+	float const w = scale * float(width);
+
+	float x, y;
+	if(align & Right)
+		x = target.x + target.w - w;
+	else if(align & Center)
+		x = target.x + (target.w - w) / 2;
+	else
+		x = target.x;
+
+	if(align & Bottom)
+		y = target.y + target.h - size;
+	else if(align & Middle)
+		y = target.y + (target.h - size) / 2;
+	else
+		y = target.y;
+
+	float const clip_x1 = float(target.x + target.w);
+	float const clip_y1 = float(target.y + target.h);
+
+	int pen = 0;
+	Uint32 previous = 0;
+	for(size_t pos = 0; pos < what.size(); )
+	{
+		Uint32 const codepoint = next_codepoint(what, pos);
+		auto const & g = glyphs.at(codepoint);
+		if(previous != 0)
+			pen += TTF_GetFontKerningSizeGlyphs32(font.get(), previous, codepoint);
+		previous = codepoint;
+
+		SDL_FRect const quad = { x + scale * (pen + g.offset), y, scale * g.src.w, scale * g.src.h };
+		pen += g.advance;
+		if(g.src.w == 0)
+			continue;
+
+		// clip to the target and move the texture coordinates along
+		float const x0 = std::max(quad.x, float(target.x));
+		float const y0 = std::max(quad.y, float(target.y));
+		float const x1 = std::min(quad.x + quad.w, clip_x1);
+		float const y1 = std::min(quad.y + quad.h, clip_y1);
+		if(x0 >= x1 or y0 >= y1)
+			continue;
+
+		SDL_FRect const src = {
+			g.src.x + (x0 - quad.x) / scale,
+			g.src.y + (y0 - quad.y) / scale,
+			(x1 - x0) / scale,
+			(y1 - y0) / scale,
 		};
-		assert(texture);
+		rendering::batch.copy(rendering::atlas.texture, src, SDL_FRect { x0, y0, x1 - x0, y1 - y0 }, color);
+	}
+}
+
+void FontRenderer::render(const SDL_Rect & target, std::string_view what, int align, SDL_Color const & color) const
+{
+	if(not (align & Wrap))
+	{
+		if(align & Ellipsis)
+			render_ellipsized(target, what, align, color);
+		else
+			render_line(target, what, align, color);
+		return;
+	}
+
+	int const line_height = height();
+	size_t const available = std::clamp<size_t>(size_t(std::max(0, target.h / line_height)), 1, max_lines);
 
-		auto [ new_it, emplaced ] = cache.emplace(what, std::move(texture));
-		assert(emplaced);
-		new_it->second.width = surface->w;
-		new_it->second.height = surface->h;
-		return new_it->second;
+	// greedy line breaking at spaces
+	std::string_view lines[max_lines];
+	size_t count = 0;
+	std::string_view rest = what;
+	while(count < available and not rest.empty())
+	{
+		rest.remove_prefix(std::min(rest.find_first_not_of(' '), rest.size()));
+		if(rest.empty())
+			break;
+
+		if(count + 1 == available or measure(rest).x <= target.w)
+		{
+			// the last line takes everything that's left
+			lines[count++] = rest;
+			rest = { };
+			break;
+		}
+
+		size_t length = fit(rest, target.w, false);
+		if(auto const space = rest.substr(0, length + 1).rfind(' '); space != std::string_view::npos and space > 0)
+			length = space;
+		else if(length == 0)
+			length = std::min(rest.size(), size_t(1)); // at least one byte to make progress
+		while(length < rest.size() and not is_lead_byte(rest[length]))
+			length += 1;
+
+		lines[count++] = rest.substr(0, length);
+		rest.remove_prefix(length);
+	}
+
+	int const block_height = int(count) * line_height;
+	int y = target.y;
+	if(align & Bottom)
+		y = target.y + target.h - block_height;
+	else if(align & Middle)
+		y = target.y + (target.h - block_height) / 2;
+
+	int const line_align = align & (Center | Right);
+	for(size_t i = 0; i < count; i++)
+	{
+		SDL_Rect const line = { target.x, y, target.w, line_height };
+		if((i + 1 == count) and (align & Ellipsis))
+			render_ellipsized(line, lines[i], line_align, color);
+		else
+			render_line(line, lines[i], line_align, color);
+		y += line_height;
 	}
 }
 
-void FontRenderer::render(const SDL_Rect & target, const std::string & what, int align, SDL_Color const & color) const
+void FontRenderer::render_ellipsized(SDL_Rect const & target, std::string_view what, int align, SDL_Color const & color) const
 {
-	Text const & str = render(what);
+	if(measure(what).x <= target.w)
+	{
+		render_line(target, what, align, color);
+		return;
+	}
+
+	// only the visible part is rasterized
+	char buffer[format_buffer_size];
+	size_t const length = fit(what, target.w, true);
+	std::memcpy(buffer, what.data(), length);
+	std::memcpy(buffer + length, ellipsis, ellipsis_length);
+	render_line(target, std::string_view(buffer, length + ellipsis_length), align, color);
+}
+
+void FontRenderer::render_line(const SDL_Rect & target, std::string_view what, int align, SDL_Color const & color) const
+{
+	if(what.size() <= atlas_max_length and render_glyphs(target, what, align, color))
+		return;
+
+	receive();
+
+	auto const hash = std::hash<std::string_view>{}(what);
+	Text const * text = find(what, hash);
+	if(text == nullptr and worker)
+	{
+		if(worker->pending.insert(hash).second)
+		{
+			{
+				std::lock_guard<std::mutex> lock { worker->mutex };
+				worker->jobs.push_back(Worker::Job { std::string(what), hash, target });
+			}
+			worker->wakeup.notify_one();
+		}
+
+		// use the glyphs until the texture is ready
+		if(render_glyphs(target, what, align, color))
+			return;
+	}
+	if(text == nullptr)
+		text = &render(what);
+
+	Text const & str = *text;
 
 	SDL_Rect dst, src;
 	dst.w = std::min(str.width, target.w);
@@ -71,33 +645,51 @@ void FontRenderer::render(const SDL_Rect & target, const std::string & what, int
 	src.x = (str.width - dst.w) / 2;
 	src.y = (str.height - dst.h) / 2;
 
-	SDL_SetTextureColorMod(str.texture.get(), color.r, color.g, color.b);
-	SDL_SetTextureAlphaMod(str.texture.get(), color.a);
+	rendering::batch.copy(str.texture.get(), &src, dst, color);
+}
+
+void FontRenderer::renderf(SDL_Rect const & target, int align, SDL_Color const & color, char const * format, ...) const
+{
+	char buffer[format_buffer_size];
+
+	va_list args;
+	va_start(args, format);
+	int const length = vsnprintf(buffer, sizeof buffer, format, args);
+	va_end(args);
+
+	if(length < 0)
+		return;
+	render(target, std::string_view(buffer, std::min(size_t(length), sizeof buffer - 1)), align, color);
+}
 
-	SDL_RenderCopy(
-		renderer,
-		str.texture.get(),
-		&src,
-		&dst
-	);
+void FontRenderer::render_scaledf(SDL_Rect const & target, float size, int align, SDL_Color const & color, char const * format, ...) const
+{
+	char buffer[format_buffer_size];
+
+	va_list args;
+	va_start(args, format);
+	int const length = vsnprintf(buffer, sizeof buffer, format, args);
+	va_end(args);
+
+	if(length < 0)
+		return;
+	render_scaled(target, std::string_view(buffer, std::min(size_t(length), sizeof buffer - 1)), size, align, color);
 }
 
 void FontRenderer::collect_garbage()
 {
-	for(auto it = cache.begin(); it != cache.end(); /* none */)
-	{
-		auto current = it;
-		it++;
-		current->second.ttl--;
-		if(current->second.ttl == 0)
-			cache.erase(current);
-	}
+	retired.clear();
 	generation += 1;
+
+	// strings of the last frame may have kept the cache above its budget
+	evict();
 }
 
 FontRenderer::Text::Text(FontRenderer::TexturePtr && tex) :
 	texture(std::move(tex)),
-	ttl(1),
+	width(0),
+	height(0),
+	hash(0),
 	last_use(~0U)
 {
 
@@ -2,9 +2,13 @@
 #define FONTRENDERER_HPP
 
 #include <SDL_ttf.h>
-#include <map>
+#include <list>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 struct FontRenderer
 {
@@ -16,6 +20,8 @@ struct FontRenderer
 		Center = 2,
 		Right = 4,
 		Bottom = 8,
+		Ellipsis = 16, //!< text that doesn't fit ends with "…" instead of being cropped
+		Wrap = 32,     //!< text is broken into as many lines as fit at spaces
 	};
 
 	using TexturePtr = std::unique_ptr<SDL_Texture, decltype(&SDL_DestroyTexture)>;
@@ -24,28 +30,151 @@ struct FontRenderer
 	{
 		TexturePtr texture;
 		int width, height;
-		size_t ttl = 1;
+		std::string key;
+		size_t hash;
 		size_t last_use;
 
 		explicit Text(TexturePtr && tex);
+
+		//! texture memory used by this text
+		size_t bytes() const {
+			return 4 * size_t(width) * size_t(height);
+		}
 	};
 
+	struct CacheStatistics
+	{
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t evictions = 0;
+	};
+
+	//! position of a glyph in the glyph atlas
+	struct Glyph
+	{
+		SDL_Rect src; // empty for blank glyphs
+		int offset;   // horizontal offset of the bitmap from the pen position
+		int advance;
+	};
+
+	//! strings up to this length are drawn glyph by glyph from the atlas,
+	//! longer ones are rendered into a texture of their own and cached.
+	static size_t constexpr atlas_max_length = 32;
+
+	//! longest text renderf can produce, longer output is truncated.
+	static size_t constexpr format_buffer_size = 256;
+
+	//! texture memory the string cache of a font may use by default.
+	static size_t constexpr default_cache_budget = 8 << 20;
+
+	//! the measure cache starts over when it has this many entries
+	static size_t constexpr max_measurements = 1024;
+
+	//! most lines the layout produces for wrapped text
+	static size_t constexpr max_lines = 16;
+
 	SDL_Renderer * renderer;
 	std::unique_ptr<TTF_Font, decltype(&TTF_CloseFont)> font;
-	mutable std::map<std::string, Text> cache;
+	//! rendered strings, most recently used first
+	mutable std::list<Text> cache;
+	//! cache entries by the hash of their string
+	mutable std::unordered_map<size_t, std::list<Text>::iterator> cache_index;
+	mutable size_t cache_bytes;
+	size_t cache_budget;
+	mutable CacheStatistics cache_stats;
+	mutable std::unordered_map<Uint32, Glyph> glyphs;
+	//! code points that didn't fit into the atlas anymore
+	mutable std::unordered_set<Uint32> atlas_rejects;
+	//! number of glyphs in the glyph cache file
+	mutable size_t saved_glyphs = 0;
 	size_t generation;
 
-	explicit FontRenderer(SDL_Renderer * renderer, TTF_Font * font);
+	//! `worker_font` is a second instance of `font` for rasterizing strings
+	//! on a background thread. Without it, strings are rendered in place.
+	explicit FontRenderer(SDL_Renderer * renderer, TTF_Font * font, TTF_Font * worker_font = nullptr, size_t cache_budget = default_cache_budget);
+
+	~FontRenderer();
 
-	Text const & render(std::string const & what) const;
+	//! returns the texture of a string, rasterizing it immediately on a miss.
+	Text const & render(std::string_view what) const;
 
-	void render(SDL_Rect const & target, std::string const & what, int align = Middle | Center, SDL_Color const & color = { 0xFF, 0xFF, 0xFF, 0xFF }) const;
+	//! Draws a string into `target`. Long strings that are not cached yet are
+	//! rasterized in the background and drawn from the glyph atlas meanwhile.
+	void render(SDL_Rect const & target, std::string_view what, int align = Middle | Center, SDL_Color const & color = { 0xFF, 0xFF, 0xFF, 0xFF }) const;
 
+	//! formats the text printf-style into a stack buffer and renders it,
+	//! so changing values can be drawn without allocating.
+	void renderf(SDL_Rect const & target, int align, SDL_Color const & color, char const * format, ...) const
+		__attribute__((format(printf, 5, 6)));
+
+	//! Ends a frame: frees textures that were dropped from the
+	//! cache while the frame still could have used them.
 	void collect_garbage();
 
+	//! returns the atlas glyph for a code point or nullptr if the atlas is full.
+	Glyph const * glyph(Uint32 codepoint) const;
+
+	//! Draws a string from the atlas glyphs scaled to a line height of `size`
+	//! pixels, positioned with subpixel precision. One reference size can
+	//! serve any size this way, including animated ones.
+	void render_scaled(SDL_Rect const & target, std::string_view what, float size, int align = Middle | Center, SDL_Color const & color = { 0xFF, 0xFF, 0xFF, 0xFF }) const;
+
+	//! formats the text like renderf and draws it like render_scaled.
+	void render_scaledf(SDL_Rect const & target, float size, int align, SDL_Color const & color, char const * format, ...) const
+		__attribute__((format(printf, 6, 7)));
+
+	//! returns the size of the rendered string, measured once by SDL_ttf.
+	SDL_Point measure(std::string_view what) const;
+
+	//! returns how many bytes of `what` fit into `width` pixels without
+	//! splitting a character, leaving room for "…" if `ellipsis` is set.
+	size_t fit(std::string_view what, int width, bool ellipsis) const;
+
 	int height() const {
 		return TTF_FontHeight(font.get());
 	}
+
+private:
+	struct Measurement
+	{
+		std::string key;
+		SDL_Point size;
+	};
+
+	//! string sizes by the hash of their string
+	mutable std::unordered_map<size_t, Measurement> measurements;
+
+	struct Worker;
+	std::unique_ptr<Worker> worker;
+
+	//! textures dropped from the cache during the current frame
+	mutable std::vector<TexturePtr> retired;
+
+	//! returns the cached string or nullptr and resolves hash collisions.
+	Text * find(std::string_view what, size_t hash) const;
+
+	//! adds the rasterized string to the cache. Takes ownership of `surface`,
+	//! which is nullptr if the string couldn't be rasterized.
+	Text & insert(std::string_view what, size_t hash, SDL_Surface * surface) const;
+
+	//! uploads strings the worker has finished.
+	void receive() const;
+
+	//! drops least recently used strings until the cache fits its budget.
+	//! Strings used in the current frame stay, as their textures may
+	//! still be referenced by the batch renderer.
+	void evict() const;
+
+	//! draws a single line, cropped to target.
+	void render_line(SDL_Rect const & target, std::string_view what, int align, SDL_Color const & color) const;
+
+	//! draws a single line, shortened with "…" if it doesn't fit.
+	void render_ellipsized(SDL_Rect const & target, std::string_view what, int align, SDL_Color const & color) const;
+
+	//! width of the string laid out from atlas glyphs, false if the atlas is full.
+	bool layout_width(std::string_view what, int & width) const;
+
+	bool render_glyphs(SDL_Rect const & target, std::string_view what, int align, SDL_Color const & color) const;
 };
 
 #endif // FONTRENDERER_HPP
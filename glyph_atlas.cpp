@@ -0,0 +1,85 @@
+#include "glyph_atlas.hpp"
+#include "kiosk.hpp"
+#include "rendering.hpp"
+
+#include <cstring>
+#include <memory>
+
+namespace
+{
+	//! free texels between glyphs, so filtering never picks up a neighbour
+	int constexpr padding = 1;
+}
+
+std::optional<SDL_Rect> glyph_atlas::insert(SDL_Surface * surface)
+{
+	int const w = surface->w + padding;
+	int const h = surface->h + padding;
+	if(w > size or h > size)
+		return std::nullopt;
+
+	if(texture == nullptr)
+	{
+		texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, size, size);
+		if(texture == nullptr)
+			die("Failed to create glyph atlas: %s", SDL_GetError());
+		rendering::context.set_texture_blend_mode(texture, SDL_BLENDMODE_BLEND);
+		// scaled text is filtered, unscaled text maps texels 1:1 anyway
+		SDL_SetTextureScaleMode(texture, SDL_ScaleModeLinear);
+		pixels.assign(size_t(size) * size, 0);
+	}
+
+	shelf * target = nullptr;
+	for(auto & s : shelves)
+	{
+		// don't put small glyphs into much higher shelves
+		if(s.height >= h and s.height <= h + h / 4 and s.x + w <= size)
+		{
+			target = &s;
+			break;
+		}
+	}
+	if(target == nullptr)
+	{
+		int const y = shelves.empty() ? 0 : (shelves.back().y + shelves.back().height);
+		if(y + h > size)
+			return std::nullopt;
+		target = &shelves.emplace_back(shelf { y, h, 0 });
+	}
+
+	SDL_Rect const rect = { target->x, target->y, surface->w, surface->h };
+	target->x += w;
+
+	std::unique_ptr<SDL_Surface, decltype(&SDL_FreeSurface)> converted { nullptr, SDL_FreeSurface };
+	if(surface->format->format != SDL_PIXELFORMAT_ARGB8888)
+	{
+		converted.reset(SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0));
+		if(not converted)
+			die("Failed to convert glyph: %s", SDL_GetError());
+		surface = converted.get();
+	}
+	SDL_UpdateTexture(texture, &rect, surface->pixels, surface->pitch);
+
+	for(int y = 0; y < rect.h; y++)
+	{
+		std::memcpy(
+			&pixels[size_t(rect.y + y) * size + size_t(rect.x)],
+			static_cast<Uint8 const *>(surface->pixels) + y * surface->pitch,
+			sizeof(Uint32) * size_t(rect.w)
+		);
+	}
+
+	return rect;
+}
+
+void glyph_atlas::read(SDL_Rect const & rect, Uint32 * dst) const
+{
+	for(int y = 0; y < rect.h; y++)
+	{
+		std::memcpy(
+			dst + size_t(y) * size_t(rect.w),
+			&pixels[size_t(rect.y + y) * size + size_t(rect.x)],
+			sizeof(Uint32) * size_t(rect.w)
+		);
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef GLYPH_ATLAS_HPP
+#define GLYPH_ATLAS_HPP
+
+#include <SDL.h>
+#include <optional>
+#include <vector>
+
+//!
+//! A single texture that the glyphs of all fonts are rasterized into,
+//! so text of any font and size can be drawn in one batch.
+//!
+//! Space is handed out in shelves: rows as high as the first bitmap
+//! placed in them. Glyphs of one font all have the same height, so each
+//! font size fills its own shelves without wasting space.
+//!
+struct glyph_atlas
+{
+	static int constexpr size = 1024;
+
+	//! created with the first glyph.
+	SDL_Texture * texture = nullptr;
+
+	//! copy of the texture in ARGB8888, so glyphs can be saved without
+	//! reading back from the GPU.
+	std::vector<Uint32> pixels;
+
+	//! copies the surface into a free spot of the atlas and returns the
+	//! occupied texels. Returns nullopt when the atlas is full.
+	std::optional<SDL_Rect> insert(SDL_Surface * surface);
+
+	//! copies the texels of `rect` into `dst` row by row.
+	void read(SDL_Rect const & rect, Uint32 * dst) const;
+
+private:
+	struct shelf
+	{
+		int y, height;
+		int x; // start of the free space
+	};
+
+	std::vector<shelf> shelves;
+};
+
+#endif // GLYPH_ATLAS_HPP
@@ -37,10 +37,13 @@ notify_result gui_module::notify(SDL_Event const & ev)
 	return module::notify(ev);
 }
 
-void gui_module::render()
+void gui_module::update()
 {
 	layout();
+}
 
+void gui_module::render()
+{
 	for(auto const & w : widgets)
 		w->render();
 }
@@ -56,7 +59,7 @@ void gui_module::add_back_button()
 {
 	auto * btn = add<button>();
 	btn->bounds = { 10, 10, 200, 200 };
-	btn->icon = home_icon;
+	btn->icon = get_icon(icon_atlas::home);
 	btn->color = { 0x03, 0xA9, 0xF4, 255 };
 	btn->on_click = []() {
 		activate<mainmenu>();
@@ -18,6 +18,8 @@ struct gui_module : module
 	//! should lay out the module. called whenever screen size changes
 	virtual void layout();
 
+	void update() override;
+
 	void render() override;
 
 	//! adds a widget of type `T`.
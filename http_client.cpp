@@ -4,131 +4,552 @@
 #include <optional>
 #include <map>
 #include <functional>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <iterator>
 #include <curl/curl.h>
 #include <curl/easy.h>
 
 #include <iostream>
-#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <string_view>
 
-
-http_client::http_client() noexcept :
-	curl(curl_easy_init()),
-	header_list(nullptr)
+namespace
 {
+	using std::chrono::steady_clock;
+	using std::chrono::milliseconds;
+
+	//! longest time the network thread sleeps without being woken up
+	auto constexpr max_poll_time = milliseconds(1000);
+
+	//! idle connections the multi handle keeps open for the next transfers.
+	//! The kiosk talks to less than ten hosts, so none has to be closed.
+	long constexpr max_connections = 16;
+
+	//! the hosts are in the local network and don't move
+	long constexpr dns_cache_seconds = 600;
+
+	struct timer
+	{
+		steady_clock::time_point due;
+		milliseconds interval;
+		std::function<void()> task;
+		int running = 0; // transfers started by the task that haven't finished
+	};
+
+	//! the timer whose task or transfer callback is running on the network
+	//! thread. Transfers started from there are counted for that timer.
+	thread_local std::shared_ptr<timer> current_timer;
+
+	struct request
+	{
+		http_client::method method;
+		std::string url;
+		CURL * curl = nullptr;
+		std::shared_ptr<curl_slist> header_list;
+		std::string owned_upload; // storage of `upload` if the caller handed the data over
+		ro_buffer<const std::byte> upload;
+		http_response response;
+		http_client::chunk_callback chunk; // receives the body instead of `response` if set
+		http_client::callback done;
+		std::shared_ptr<timer> owner;
+
+		// response caching, see http_client::set_caching
+		unsigned cache_id = 0; // 0 if not cached
+		curl_slist * conditional_headers = nullptr;
+		std::string etag;
+		std::string last_modified;
+		long max_age = -1; // seconds, -1 if the response may not be reused
+	};
+
+	//! validators of the last response for a URL
+	struct cache_entry
+	{
+		std::string etag;
+		std::string last_modified;
+		steady_clock::time_point fresh_until;
+	};
+
+	bool equals_ignore_case(std::string_view a, std::string_view b)
+	{
+		return a.size() == b.size() and std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+			return tolower(static_cast<unsigned char>(x)) == tolower(static_cast<unsigned char>(y));
+		});
+	}
+
+	std::string_view trim(std::string_view text)
+	{
+		while(not text.empty() and isspace(static_cast<unsigned char>(text.front())))
+			text.remove_prefix(1);
+		while(not text.empty() and isspace(static_cast<unsigned char>(text.back())))
+			text.remove_suffix(1);
+		return text;
+	}
+
+	//! reads the max-age of a Cache-Control header, -1 if the response must be revalidated
+	long parse_max_age(std::string_view value)
+	{
+		long max_age = -1;
+		while(not value.empty())
+		{
+			auto const end = std::min(value.find(','), value.size());
+			auto const directive = trim(value.substr(0, end));
+			value.remove_prefix(std::min(end + 1, value.size()));
+
+			if(equals_ignore_case(directive, "no-cache") or equals_ignore_case(directive, "no-store"))
+				return -1;
+			if(directive.size() > 8 and equals_ignore_case(directive.substr(0, 8), "max-age="))
+				max_age = strtol(std::string(directive.substr(8)).c_str(), nullptr, 10);
+		}
+		return max_age;
+	}
+
+	std::size_t header_data(char * data, size_t size, size_t nitems, void *stream)
+	{
+		auto & t = *reinterpret_cast<request*>(stream);
+		auto const length = size * nitems;
+		auto const line = trim(std::string_view(data, length));
+
+		if(line.substr(0, 5) == "HTTP/")
+		{
+			// a new response starts, e.g. after a redirect
+			t.etag.clear();
+			t.last_modified.clear();
+			t.max_age = -1;
+			return length;
+		}
+
+		auto const colon = line.find(':');
+		if(colon == line.npos)
+			return length;
+		auto const name = line.substr(0, colon);
+		auto const value = trim(line.substr(colon + 1));
+
+		if(equals_ignore_case(name, "ETag"))
+			t.etag = value;
+		else if(equals_ignore_case(name, "Last-Modified"))
+			t.last_modified = value;
+		else if(equals_ignore_case(name, "Cache-Control"))
+			t.max_age = parse_max_age(value);
+
+		return length;
+	}
+
+	std::size_t write_data(void * data, size_t size, size_t nmemb, void *stream)
+	{
+		auto & t = *reinterpret_cast<request*>(stream);
+		auto const * const bytes = static_cast<std::byte const *>(data);
+		auto const length = size * nmemb;
+
+		if(t.chunk)
+			return t.chunk(ro_buffer<const std::byte> { bytes, length }) ? length : 0;
+
+		auto & body = t.response.body;
+
+		if(body.capacity() == 0)
+		{
+			// size the body once if the server tells the length. With
+			// compression it's the compressed length, still a good start.
+			curl_off_t content_length = -1;
+			curl_easy_getinfo(t.curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length);
+			if(content_length > 0)
+				body.reserve(size_t(content_length));
+		}
+
+		body.insert(body.end(), bytes, bytes + length);
+
+		return length;
+	}
+
+	//! Owns the curl multi handle and the network thread.
+	//!
+	//! All transfers run in the multi handle, which keeps one pool of
+	//! keep-alive connections and one DNS cache for them, so a request to
+	//! a known host needs a single round trip. The share adds the TLS
+	//! sessions, which the multi handle doesn't share. Connections and DNS
+	//! must stay out of the share, it would replace the pool of the multi
+	//! handle and CURLMOPT_MAXCONNECTS wouldn't apply anymore. The handles
+	//! are only used on the network thread, so the share needs no lock
+	//! callbacks.
+	struct engine
+	{
+		CURLM * const multi = curl_multi_init();
+		CURLSH * const share = curl_share_init();
+
+		engine()
+		{
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdisabled-macro-expansion"
-	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1); //Prevent "longjmp causes uninitialized stack frame" bug
-	curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "deflate");
-	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_data);
-	curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
-	curl_easy_setopt(curl, CURLOPT_READDATA, this);
-	curl_easy_setopt(curl, CURLOPT_READFUNCTION, read_data);
-	curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);
+			curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+			curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, max_connections);
 #pragma clang diagnostic pop
-}
+			thread = std::thread([this]() { run(); });
+		}
 
-http_client::~http_client() noexcept
-{
-	if(curl != nullptr)
-		curl_easy_cleanup(curl);
-}
+		//! stops the network thread at exit. Transfers that are still
+		//! running are abandoned without calling their callbacks.
+		~engine()
+		{
+			stopping = true;
+			curl_multi_wakeup(multi);
+			thread.join();
 
-void http_client::set_headers(std::map<std::string, std::string> headers)
-{
-	if(header_list != nullptr)
-		curl_slist_free_all(header_list);
-	header_list = nullptr;
+			for(CURL * curl : idle_handles)
+				curl_easy_cleanup(curl);
+			curl_multi_cleanup(multi);
+			curl_share_cleanup(share);
+		}
 
-	if(headers.size() > 0)
-	{
-		for(auto const & kvp : headers)
-			header_list = curl_slist_append(header_list, (kvp.first + ": " + kvp.second).c_str());
-	}
-	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
-}
+		void submit(std::unique_ptr<request> t)
+		{
+			if((t->owner = current_timer))
+				t->owner->running++;
 
-std::optional<std::vector<std::byte>> http_client::transfer(method method, std::string const & url)
-{
-	return transfer(method, url, [](float){});
-}
+			std::lock_guard _ { lock };
+			queue.push_back(std::move(t));
+			curl_multi_wakeup(multi);
+		}
 
-std::optional<std::vector<std::byte>> http_client::transfer(method method, std::string const & url, std::function<void(float)> const & on_progress)
-{
-	return transfer(method, url, ro_buffer<const std::byte> { }, on_progress);
-}
+		void invalidate(unsigned cache_id, std::string const & url)
+		{
+			std::lock_guard _ { lock };
+			invalidated.emplace_back(cache_id, url);
+			curl_multi_wakeup(multi);
+		}
 
-std::optional<std::vector<std::byte>> http_client::transfer(method method, std::string const & url, ro_buffer<const std::byte> const & data)
-{
-	return transfer(method, url, data, [](float){});
-}
+		void add_timer(std::shared_ptr<timer> t)
+		{
+			std::lock_guard _ { lock };
+			new_timers.push_back(std::move(t));
+			curl_multi_wakeup(multi);
+		}
 
-std::optional<std::vector<std::byte>> http_client::transfer(method method, std::string const & url, ro_buffer<const std::byte> const & data, std::function<void(float)> const & on_progress)
-{
-	upload_buffer = data;
-	upload_ptr = 0;
+	private:
+		std::thread thread;
+		std::atomic_bool stopping { false };
+
+		std::mutex lock;
+		std::vector<std::unique_ptr<request>> queue;
+		std::vector<std::shared_ptr<timer>> new_timers;
+		std::vector<std::pair<unsigned, std::string>> invalidated; // cache entries to drop
+
+		// only used on the network thread
+		std::vector<std::shared_ptr<timer>> timers;
+		std::vector<CURL *> idle_handles; // reused for the next transfers
+		std::map<std::pair<unsigned, std::string>, cache_entry> cache; // by client and URL
 
-	buffer.clear();
+		CURL * acquire_handle()
+		{
+			CURL * curl;
+			if(idle_handles.empty())
+			{
+				curl = curl_easy_init();
+				if(curl == nullptr)
+					return nullptr;
+			}
+			else
+			{
+				curl = idle_handles.back();
+				idle_handles.pop_back();
+				curl_easy_reset(curl);
+			}
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdisabled-macro-expansion"
-	curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-	curl_easy_setopt(curl, CURLOPT_INFILESIZE, long(data.size()));
-	switch(method)
-	{
-		case get:
-			curl_easy_setopt(curl, CURLOPT_POST, 0L);
-			curl_easy_setopt(curl, CURLOPT_UPLOAD,  0L);
-			break;
-		case post:
-			curl_easy_setopt(curl, CURLOPT_POST, 1L);
-			curl_easy_setopt(curl, CURLOPT_UPLOAD,  0L);
-			break;
-		case put:
-			curl_easy_setopt(curl, CURLOPT_POST, 0L);
-			curl_easy_setopt(curl, CURLOPT_UPLOAD,  1L);
-			break;
-	}
+			curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+			curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1); //Prevent "longjmp causes uninitialized stack frame" bug
+			curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "deflate");
+			curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_data);
+			curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);
+			curl_easy_setopt(curl, CURLOPT_SHARE, share);
+			curl_easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, dns_cache_seconds);
+			curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
 #pragma clang diagnostic pop
+			return curl;
+		}
+
+		//! returns true if the cached response is still fresh,
+		//! otherwise asks the server to send it only if it has changed.
+		bool revalidate(request & t)
+		{
+			auto const entry = cache.find({ t.cache_id, t.url });
+			if(entry == cache.end())
+				return false;
+
+			if(steady_clock::now() < entry->second.fresh_until)
+				return true;
+
+			for(auto const * item = t.header_list.get(); item != nullptr; item = item->next)
+				t.conditional_headers = curl_slist_append(t.conditional_headers, item->data);
+			if(not entry->second.etag.empty())
+				t.conditional_headers = curl_slist_append(t.conditional_headers, ("If-None-Match: " + entry->second.etag).c_str());
+			if(not entry->second.last_modified.empty())
+				t.conditional_headers = curl_slist_append(t.conditional_headers, ("If-Modified-Since: " + entry->second.last_modified).c_str());
+			return false;
+		}
+
+		//! remembers the validators of a finished transfer.
+		void store(request & t)
+		{
+			if(not t.response or (t.response.status != 200 and t.response.status != 304))
+			{
+				// the caller has no valid data anymore, the next response must be complete
+				cache.erase({ t.cache_id, t.url });
+				return;
+			}
+
+			t.response.unchanged = (t.response.status == 304);
+
+			auto & entry = cache[{ t.cache_id, t.url }];
+			if(not t.response.unchanged)
+			{
+				entry.etag = std::move(t.etag);
+				entry.last_modified = std::move(t.last_modified);
+			}
+			entry.fresh_until = steady_clock::now() + std::chrono::seconds(std::max(0L, t.max_age));
+
+			if(entry.etag.empty() and entry.last_modified.empty() and t.max_age <= 0)
+				cache.erase({ t.cache_id, t.url }); // nothing to reuse
+		}
+
+		void start(std::unique_ptr<request> t)
+		{
+			if(t->cache_id != 0 and revalidate(*t))
+			{
+				// status stays 0, nothing was transferred
+				t->response.unchanged = true;
+				finish(std::move(t));
+				return;
+			}
+
+			auto * const curl = t->curl = acquire_handle();
+			if(curl == nullptr)
+			{
+				t->response.result = CURLE_FAILED_INIT;
+				finish(std::move(t));
+				return;
+			}
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdisabled-macro-expansion"
+			curl_easy_setopt(curl, CURLOPT_PRIVATE, t.get());
+			curl_easy_setopt(curl, CURLOPT_WRITEDATA, t.get());
+			if(t->conditional_headers != nullptr)
+				curl_easy_setopt(curl, CURLOPT_HTTPHEADER, t->conditional_headers);
+			else
+				curl_easy_setopt(curl, CURLOPT_HTTPHEADER, t->header_list.get());
+			if(t->cache_id != 0)
+			{
+				curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_data);
+				curl_easy_setopt(curl, CURLOPT_HEADERDATA, t.get());
+			}
+			curl_easy_setopt(curl, CURLOPT_URL, t->url.c_str());
+			switch(t->method)
+			{
+				case http_client::get:
+					break;
+				case http_client::put:
+					// a PUT is sent like a POST, just with another method
+					curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+					[[fallthrough]];
+				case http_client::post:
+					// curl sends the data right from the request, without a copy
+					curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, curl_off_t(t->upload.size()));
+					curl_easy_setopt(curl, CURLOPT_POSTFIELDS, t->upload.data());
+					break;
+			}
+#pragma clang diagnostic pop
+			curl_multi_add_handle(multi, curl);
+			t.release(); // owned by the multi handle until it's done
+		}
+
+		void finish(std::unique_ptr<request> t)
+		{
+			if(t->response.result != CURLE_OK)
+				std::cerr << curl_easy_strerror(t->response.result) << std::endl;
+			if(t->cache_id != 0 and t->curl != nullptr)
+				store(*t);
+			curl_slist_free_all(t->conditional_headers);
+			// follow-up transfers count for the same timer
+			current_timer = t->owner;
+			try
+			{
+				if(t->done)
+					t->done(std::move(t->response));
+			}
+			catch(...)
+			{
+				// a failing callback must not take the other transfers down
+			}
+			current_timer = nullptr;
+
+			if(t->owner)
+				t->owner->running--;
+			if(t->curl != nullptr)
+				idle_handles.push_back(t->curl);
+		}
+
+		//! runs due timers and returns the time until the next one is due.
+		milliseconds run_timers()
+		{
+			auto const now = steady_clock::now();
+			auto next = now + max_poll_time;
+			for(auto & t : timers)
+			{
+				// a slow server is not asked again before it has answered
+				if(t->due <= now and t->running == 0)
+				{
+					current_timer = t;
+					try
+					{
+						t->task();
+					}
+					catch(...)
+					{
+					}
+					current_timer = nullptr;
+					t->due = std::max(t->due + t->interval, now);
+				}
+				if(t->running == 0)
+					next = std::min(next, t->due);
+			}
+			return std::chrono::duration_cast<milliseconds>(next - now);
+		}
+
+		void run()
+		{
+			while(not stopping)
+			{
+				std::vector<std::unique_ptr<request>> started;
+				{
+					std::lock_guard _ { lock };
+					// before the queued requests, which may be for the same URL
+					for(auto const & key : invalidated)
+						cache.erase(key);
+					invalidated.clear();
+					std::swap(started, queue);
+					std::move(new_timers.begin(), new_timers.end(), std::back_inserter(timers));
+					new_timers.clear();
+				}
+				for(auto & t : started)
+					start(std::move(t));
 
-	if(on_progress)
-		on_progress(0.0f);
+				int running;
+				curl_multi_perform(multi, &running);
 
-	CURLcode res = curl_easy_perform(curl);
-	if (res != CURLE_OK)
+				int pending;
+				while(CURLMsg * msg = curl_multi_info_read(multi, &pending))
+				{
+					if(msg->msg != CURLMSG_DONE)
+						continue;
+
+					request * raw;
+					curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &raw);
+					std::unique_ptr<request> t { raw };
+
+					t->response.result = msg->data.result;
+					curl_easy_getinfo(t->curl, CURLINFO_RESPONSE_CODE, &t->response.status);
+					curl_multi_remove_handle(multi, t->curl);
+
+					finish(std::move(t));
+				}
+
+				auto const timeout = run_timers();
+
+				// transfers queued by the timers or callbacks wake the poll up right away
+				curl_multi_poll(multi, nullptr, 0, int(timeout.count()), nullptr);
+			}
+		}
+	};
+
+	engine & network()
 	{
-		std::cerr << curl_easy_strerror(res) << std::endl;
-		return std::nullopt;
+		static engine instance;
+		return instance;
 	}
+}
+
+void http_client::set_headers(std::map<std::string, std::string> headers)
+{
+	curl_slist * list = nullptr;
+	for(auto const & kvp : headers)
+		list = curl_slist_append(list, (kvp.first + ": " + kvp.second).c_str());
+	header_list = std::shared_ptr<curl_slist>(list, curl_slist_free_all);
+}
 
-	if(on_progress)
-		on_progress(100.0f);
+void http_client::set_caching(bool enabled)
+{
+	static std::atomic<unsigned> last_id { 0 };
+	cache_id = enabled ? ++last_id : 0;
+}
 
-	return buffer;
+void http_client::invalidate_cache(std::string const & url) const
+{
+	if(cache_id != 0)
+		network().invalidate(cache_id, url);
 }
 
-std::size_t http_client::read_data(void * data, size_t size, size_t nitems, void *stream)
+void http_client::transfer_async(method method, std::string const & url, callback done) const
 {
-	auto & http = *reinterpret_cast<http_client*>(stream);
+	transfer_async(method, url, ro_buffer<const std::byte> { }, std::move(done));
+}
 
-	auto const max_length = http.upload_buffer.size() - http.upload_ptr;
-	auto read_length = size * nitems;
-	if(read_length > max_length)
-		read_length = max_length;
+void http_client::transfer_async(method method, std::string const & url, ro_buffer<const std::byte> const & data, callback done) const
+{
+	auto t = std::make_unique<request>();
+	t->method = method;
+	t->url = url;
+	t->header_list = header_list;
+	t->upload = data;
+	t->done = std::move(done);
+	if(method == get)
+		t->cache_id = cache_id;
+	network().submit(std::move(t));
+}
 
-	memcpy(data, http.upload_buffer.data() + http.upload_ptr, read_length);
-	http.upload_ptr += read_length;
+void http_client::transfer_async(method method, std::string const & url, std::string data, callback done) const
+{
+	auto t = std::make_unique<request>();
+	t->method = method;
+	t->url = url;
+	t->header_list = header_list;
+	t->owned_upload = std::move(data);
+	t->upload = { reinterpret_cast<std::byte const *>(t->owned_upload.data()), t->owned_upload.size() };
+	t->done = std::move(done);
+	network().submit(std::move(t));
+}
 
-	return read_length;
+void http_client::stream_async(std::string const & url, chunk_callback chunk, callback done) const
+{
+	auto t = std::make_unique<request>();
+	t->method = get;
+	t->url = url;
+	t->header_list = header_list;
+	t->chunk = std::move(chunk);
+	t->done = std::move(done);
+	network().submit(std::move(t));
 }
 
-std::size_t http_client::write_data(void * data, size_t size, size_t nmemb, void *stream)
+std::optional<std::vector<std::byte>> http_client::transfer(method method, std::string const & url) const
 {
-	auto & http = *reinterpret_cast<http_client*>(stream);
+	return transfer(method, url, ro_buffer<const std::byte> { });
+}
 
-	auto const start = http.buffer.size();
-	auto const length = size * nmemb;
-	http.buffer.resize(http.buffer.size() + length);
-	memcpy(&http.buffer[start], data, length);
+std::optional<std::vector<std::byte>> http_client::transfer(method method, std::string const & url, ro_buffer<const std::byte> const & data) const
+{
+	std::promise<std::optional<std::vector<std::byte>>> result;
+	transfer_async(method, url, data, [&](http_response && response) {
+		if(response)
+			result.set_value(std::move(response.body));
+		else
+			result.set_value(std::nullopt);
+	});
+	return result.get_future().get();
+}
 
-	return length;
+void http_client::every(std::chrono::milliseconds interval, std::function<void()> task)
+{
+	network().add_timer(std::make_shared<timer>(timer { steady_clock::now(), interval, std::move(task) }));
 }
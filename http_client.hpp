@@ -5,6 +5,9 @@
 #include <vector>
 #include <optional>
 #include <map>
+#include <memory>
+#include <string>
+#include <chrono>
 #include <functional>
 #include <curl/curl.h>
 #include <curl/easy.h>
@@ -40,36 +43,82 @@ struct ro_buffer
 	}
 };
 
+//! Result of a transfer.
+struct http_response
+{
+	CURLcode result = CURLE_OK;
+	long status = 0; // HTTP status code, 0 if answered from the cache without a transfer
+	std::vector<std::byte> body;
+
+	//! the response is the same as the last one for this URL, so the
+	//! body is empty. Only set for clients with caching enabled.
+	bool unchanged = false;
+
+	//! true if the transfer completed, whatever the status code is.
+	explicit operator bool() const {
+		return result == CURLE_OK;
+	}
+};
+
 //! Simple frontend for libcurl to allow the download of HTTP files.
+//!
+//! All transfers of the kiosk run concurrently on a single network
+//! thread that drives a curl multi handle. A client only holds the
+//! settings of its requests, so it's cheap to create and copy.
 struct http_client
 {
 	enum method { get, put, post };
 
-	http_client() noexcept;
-	http_client(http_client const &) = delete;
-	http_client(http_client && other) = default;
-	~http_client() noexcept;
+	//! called on the network thread when a transfer has finished.
+	//! The response may be moved out, the body is never copied.
+	using callback = std::function<void(http_response && response)>;
+
+	//! called on the network thread for each part of the body as it
+	//! arrives. Returning false aborts the transfer with CURLE_WRITE_ERROR.
+	using chunk_callback = std::function<bool(ro_buffer<const std::byte> chunk)>;
 
 	void set_headers(std::map<std::string, std::string> headers);
 
-	std::optional<std::vector<std::byte>> transfer(method method, std::string const & url);
+	//! remembers the ETag, Last-Modified and Cache-Control max-age of GET
+	//! responses. Later requests for the same URL are answered without a
+	//! transfer while the response is fresh, and are conditional otherwise.
+	//! Both cases report the response as `unchanged`. The cache belongs
+	//! to this client and its copies.
+	void set_caching(bool enabled);
 
-	std::optional<std::vector<std::byte>> transfer(method method, std::string const & url, std::function<void(float)> const & on_progress);
+	//! forgets the cached response for `url`, so the next request
+	//! transfers it completely. Used by callbacks that couldn't use
+	//! the body, as later responses would only report `unchanged`.
+	void invalidate_cache(std::string const & url) const;
 
-	std::optional<std::vector<std::byte>> transfer(method method, std::string const & url, ro_buffer<const std::byte> const & data);
+	//! starts a transfer and returns immediately. `done` must not block,
+	//! as it delays all other transfers.
+	void transfer_async(method method, std::string const & url, callback done) const;
 
-	std::optional<std::vector<std::byte>> transfer(method method, std::string const & url, ro_buffer<const std::byte> const & data, std::function<void(float)> const & on_progress);
+	//! uploads `data` without copying it, so it must stay valid until `done` is called.
+	void transfer_async(method method, std::string const & url, ro_buffer<const std::byte> const & data, callback done) const;
 
-private:
-	void * curl;
-	std::vector<std::byte> buffer;
-	ro_buffer<const std::byte> upload_buffer;
-	size_t upload_ptr;
-	curl_slist * header_list;
+	//! uploads `data`, which is kept with the transfer.
+	void transfer_async(method method, std::string const & url, std::string data, callback done) const;
+
+	//! starts a GET transfer that hands the body to `chunk` piece by piece
+	//! instead of collecting it, so it can be parsed while it is received.
+	//! The response passed to `done` has an empty body. Not cached.
+	void stream_async(std::string const & url, chunk_callback chunk, callback done) const;
 
-	static std::size_t read_data(void * data, size_t size, size_t nitems, void *stream);
+	//! waits for a transfer. Must not be called on the network thread.
+	std::optional<std::vector<std::byte>> transfer(method method, std::string const & url) const;
 
-	static std::size_t write_data(void * data, size_t size, size_t nmemb, void *stream);
+	std::optional<std::vector<std::byte>> transfer(method method, std::string const & url, ro_buffer<const std::byte> const & data) const;
+
+	//! calls `task` on the network thread now and then every `interval`,
+	//! e.g. to poll a server with transfer_async().
+	static void every(std::chrono::milliseconds interval, std::function<void()> task);
+
+private:
+	// shared with the transfers that are still running
+	std::shared_ptr<curl_slist> header_list;
+	unsigned cache_id = 0; // identifies the cached responses of this client and its copies
 };
 
 
@@ -0,0 +1,343 @@
+#include "json_stream.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	bool is_whitespace(char c)
+	{
+		return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+	}
+
+	bool is_number_char(char c)
+	{
+		return (c >= '0' and c <= '9') or c == '-' or c == '+' or c == '.' or c == 'e' or c == 'E';
+	}
+
+	int hex_value(char c)
+	{
+		if(c >= '0' and c <= '9') return c - '0';
+		if(c >= 'a' and c <= 'f') return c - 'a' + 10;
+		if(c >= 'A' and c <= 'F') return c - 'A' + 10;
+		return -1;
+	}
+
+	char const * literal_for(char first)
+	{
+		switch(first)
+		{
+			case 't': return "true";
+			case 'f': return "false";
+			default:  return "null";
+		}
+	}
+}
+
+json_stream::json_stream(json_handler & handler) :
+  handler(handler)
+{
+
+}
+
+bool json_stream::feed(std::string_view chunk)
+{
+	char const * it = chunk.data();
+	char const * const end = it + chunk.size();
+	while(it != end)
+	{
+		if(state == error)
+			return false;
+
+		if(state == in_string)
+		{
+			// copy the plain part of a string at once
+			char const * plain = it;
+			while(plain != end and *plain != '"' and *plain != '\\' and static_cast<unsigned char>(*plain) >= 0x20)
+				plain++;
+			if(plain != it)
+			{
+				if(high_surrogate != 0)
+				{
+					state = error; // unpaired UTF-16 surrogate
+					return false;
+				}
+				token.append(it, plain);
+				it = plain;
+				continue;
+			}
+		}
+
+		if(not parse(*it++))
+		{
+			state = error;
+			return false;
+		}
+	}
+	return state != error;
+}
+
+bool json_stream::finish()
+{
+	if(state == in_number and containers.empty())
+	{
+		if(not end_number())
+			state = error;
+	}
+	return state == after_value and containers.empty();
+}
+
+bool json_stream::parse(char c)
+{
+	switch(state)
+	{
+		case value:
+			if(is_whitespace(c))
+				return true;
+			return start_value(c);
+
+		case first_value:
+			if(is_whitespace(c))
+				return true;
+			if(c == ']')
+			{
+				containers.pop_back();
+				return handler.end_array() and end_value();
+			}
+			return start_value(c);
+
+		case first_key:
+		case next_key:
+			if(is_whitespace(c))
+				return true;
+			if(c == '}' and state == first_key)
+			{
+				containers.pop_back();
+				return handler.end_object() and end_value();
+			}
+			if(c != '"')
+				return false;
+			token.clear();
+			token_is_key = true;
+			state = in_string;
+			return true;
+
+		case colon:
+			if(is_whitespace(c))
+				return true;
+			if(c != ':')
+				return false;
+			state = value;
+			return true;
+
+		case after_value:
+			if(is_whitespace(c))
+				return true;
+			if(containers.empty())
+				return false; // only one value per document
+			if(c == ',')
+			{
+				state = (containers.back() == '{') ? next_key : value;
+				return true;
+			}
+			if(c == '}' and containers.back() == '{')
+			{
+				containers.pop_back();
+				return handler.end_object() and end_value();
+			}
+			if(c == ']' and containers.back() == '[')
+			{
+				containers.pop_back();
+				return handler.end_array() and end_value();
+			}
+			return false;
+
+		case in_string:
+			if(high_surrogate != 0 and c != '\\')
+				return false;
+			if(c == '"')
+				return end_string();
+			if(c == '\\')
+			{
+				state = in_escape;
+				return true;
+			}
+			return false; // unescaped control character
+
+		case in_escape:
+			if(high_surrogate != 0 and c != 'u')
+				return false;
+			state = in_string;
+			switch(c)
+			{
+				case '"':  token += '"';  return true;
+				case '\\': token += '\\'; return true;
+				case '/':  token += '/';  return true;
+				case 'b':  token += '\b'; return true;
+				case 'f':  token += '\f'; return true;
+				case 'n':  token += '\n'; return true;
+				case 'r':  token += '\r'; return true;
+				case 't':  token += '\t'; return true;
+				case 'u':
+					codepoint = 0;
+					codepoint_digits = 0;
+					state = in_unicode;
+					return true;
+				default:
+					return false;
+			}
+
+		case in_unicode:
+		{
+			int const digit = hex_value(c);
+			if(digit < 0)
+				return false;
+			codepoint = 16 * codepoint + unsigned(digit);
+			if(++codepoint_digits < 4)
+				return true;
+
+			state = in_string;
+			if(codepoint >= 0xD800 and codepoint <= 0xDBFF)
+			{
+				if(high_surrogate != 0)
+					return false;
+				high_surrogate = codepoint;
+				return true;
+			}
+			if(codepoint >= 0xDC00 and codepoint <= 0xDFFF)
+			{
+				if(high_surrogate == 0)
+					return false;
+				codepoint = 0x10000 + ((high_surrogate - 0xD800) << 10) + (codepoint - 0xDC00);
+				high_surrogate = 0;
+			}
+			else if(high_surrogate != 0)
+			{
+				return false;
+			}
+			append_utf8(codepoint);
+			return true;
+		}
+
+		case in_number:
+			if(is_number_char(c))
+			{
+				token += c;
+				return true;
+			}
+			// the number ends with the next token, which still needs parsing
+			return end_number() and parse(c);
+
+		case in_literal:
+		{
+			char const * const literal = literal_for(token[0]);
+			if(c != literal[token.size()])
+				return false;
+			token += c;
+			if(token.size() < strlen(literal))
+				return true;
+			return end_literal();
+		}
+
+		case error:
+			return false;
+	}
+	return false;
+}
+
+bool json_stream::start_value(char c)
+{
+	switch(c)
+	{
+		case '{':
+			containers.push_back('{');
+			state = first_key;
+			return handler.start_object();
+
+		case '[':
+			containers.push_back('[');
+			state = first_value;
+			return handler.start_array();
+
+		case '"':
+			token.clear();
+			token_is_key = false;
+			state = in_string;
+			return true;
+
+		case 't':
+		case 'f':
+		case 'n':
+			token.assign(1, c);
+			state = in_literal;
+			return true;
+
+		default:
+			if(c != '-' and (c < '0' or c > '9'))
+				return false;
+			token.assign(1, c);
+			state = in_number;
+			return true;
+	}
+}
+
+bool json_stream::end_value()
+{
+	state = after_value;
+	return true;
+}
+
+bool json_stream::end_string()
+{
+	if(token_is_key)
+	{
+		state = colon;
+		return handler.key(token);
+	}
+	return handler.string(token) and end_value();
+}
+
+bool json_stream::end_number()
+{
+	char * number_end = nullptr;
+	double const number = strtod(token.c_str(), &number_end);
+	if(number_end != token.c_str() + token.size())
+		return false;
+	return handler.number(number) and end_value();
+}
+
+bool json_stream::end_literal()
+{
+	switch(token[0])
+	{
+		case 't': return handler.boolean(true) and end_value();
+		case 'f': return handler.boolean(false) and end_value();
+		default:  return handler.null() and end_value();
+	}
+}
+
+void json_stream::append_utf8(unsigned cp)
+{
+	if(cp < 0x80)
+	{
+		token += char(cp);
+	}
+	else if(cp < 0x800)
+	{
+		token += char(0xC0 | (cp >> 6));
+		token += char(0x80 | (cp & 0x3F));
+	}
+	else if(cp < 0x10000)
+	{
+		token += char(0xE0 | (cp >> 12));
+		token += char(0x80 | ((cp >> 6) & 0x3F));
+		token += char(0x80 | (cp & 0x3F));
+	}
+	else
+	{
+		token += char(0xF0 | (cp >> 18));
+		token += char(0x80 | ((cp >> 12) & 0x3F));
+		token += char(0x80 | ((cp >> 6) & 0x3F));
+		token += char(0x80 | (cp & 0x3F));
+	}
+}
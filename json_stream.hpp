@@ -0,0 +1,82 @@
+#ifndef JSON_STREAM_HPP
+#define JSON_STREAM_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+//!
+//! Receives the values of a JSON document in order of appearance.
+//! Returning false from any of the functions stops the parser.
+//!
+//! Strings and keys are only valid during the call.
+//!
+struct json_handler
+{
+	virtual ~json_handler() = default;
+
+	virtual bool null() { return true; }
+	virtual bool boolean(bool) { return true; }
+	virtual bool number(double) { return true; }
+	virtual bool string(std::string_view) { return true; }
+	virtual bool key(std::string_view) { return true; }
+	virtual bool start_object() { return true; }
+	virtual bool end_object() { return true; }
+	virtual bool start_array() { return true; }
+	virtual bool end_array() { return true; }
+};
+
+//!
+//! Incremental JSON parser that is fed with the document piece by piece,
+//! e.g. from the chunks of a HTTP transfer, and reports it to a handler.
+//! No document tree is built, only the current string or number is buffered.
+//!
+struct json_stream
+{
+	explicit json_stream(json_handler & handler);
+
+	//! parses the next part of the document. Returns false on a syntax
+	//! error or if the handler stopped, then all further input is ignored.
+	bool feed(std::string_view chunk);
+
+	//! ends the document. Returns true if exactly one complete value was fed.
+	bool finish();
+
+	bool failed() const { return state == error; }
+
+private:
+	enum parser_state
+	{
+		value,        // expects a value
+		first_value,  // after '[', expects a value or ']'
+		first_key,    // after '{', expects a key or '}'
+		next_key,     // after ',' in an object
+		colon,        // after a key
+		after_value,  // expects ',' or the end of the container
+		in_string,
+		in_escape,
+		in_unicode,
+		in_number,
+		in_literal,
+		error,
+	};
+
+	json_handler & handler;
+	parser_state state = value;
+	std::vector<char> containers; // '{' or '[' for each open container
+	std::string token;            // current string, number or literal
+	bool token_is_key = false;
+	unsigned codepoint = 0;       // of a \u escape
+	int codepoint_digits = 0;
+	unsigned high_surrogate = 0;  // of an escaped UTF-16 pair
+
+	bool parse(char c);
+	bool start_value(char c);
+	bool end_value();
+	bool end_string();
+	bool end_number();
+	bool end_literal();
+	void append_utf8(unsigned cp);
+};
+
+#endif // JSON_STREAM_HPP
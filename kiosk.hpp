@@ -10,16 +10,33 @@
 
 #define die(...) __die(__FILE__, __LINE__, __VA_ARGS__)
 
+struct module;
+
+//! Requests that a new frame is rendered as soon as possible.
+//! May be called from any thread, e.g. after a fetcher changed its data.
+//! Redraws the whole screen, so prefer one of the overloads below.
+void request_redraw();
+
+//! Requests that the given region of the screen is redrawn.
+void request_redraw(SDL_Rect const & region);
+
+//! Requests that the data of `source` is redrawn, see module::data_changed().
+//! Nothing is redrawn while the module isn't shown.
+void request_redraw(module * source);
+
 extern SDL_Renderer * renderer;
 extern SDL_Window * window;
-extern SDL_Texture * home_icon;
 
-extern double time_step;  // delta time in seconds
+extern double time_step;  // delta time in seconds, clamped to keep animations smooth after idle periods
 extern double total_time; // total time in seconds since start
 
 extern glm::ivec2 screen_size; // screen size in pixels
 
 extern std::filesystem::path resource_root; // root folder for all resources
 
+//! $XDG_CACHE_HOME/shack-kiosk or ~/.cache/shack-kiosk,
+//! empty if neither variable is set.
+std::filesystem::path cache_directory();
+
 
 #endif // KIOSK_HPP
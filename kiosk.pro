@@ -37,7 +37,20 @@ SOURCES += \
     modules/lightroom.cpp \
     modules/tramview.cpp \
     http_client.cpp \
-    modules/powerview.cpp
+    modules/powerview.cpp \
+    damage_tracker.cpp \
+    mesh.cpp \
+    transition.cpp \
+    batch_renderer.cpp \
+    render_context.cpp \
+    glyph_atlas.cpp \
+    font_manager.cpp \
+    asset_manager.cpp \
+    thread_pool.cpp \
+    sprite.cpp \
+    resource_bundle.cpp \
+    startup_trace.cpp \
+    json_stream.cpp
 
 HEADERS += \
     fontrenderer.hpp \
@@ -57,4 +70,42 @@ HEADERS += \
     modules/lightroom.hpp \
     modules/tramview.hpp \
     http_client.hpp \
-    modules/powerview.hpp
+    modules/powerview.hpp \
+    damage_tracker.hpp \
+    mesh.hpp \
+    transition.hpp \
+    batch_renderer.hpp \
+    render_context.hpp \
+    glyph_atlas.hpp \
+    font_manager.hpp \
+    asset_manager.hpp \
+    thread_pool.hpp \
+    sprite.hpp \
+    resource_bundle.hpp \
+    startup_trace.hpp \
+    json_stream.hpp
+
+# packs resources/icons and resources/tram into resources/icon_atlas.png
+# and generates icon_atlas.hpp with the source rect of every icon
+pack_icons.input = $$PWD/tools/pack_icons.cpp
+pack_icons.output = $$OUT_PWD/icon_atlas.hpp
+pack_icons.depends = $$files($$PWD/resources/icons/*.png) $$files($$PWD/resources/tram/*.png)
+pack_icons.commands = \
+    $$QMAKE_CXX -std=c++17 -O2 ${QMAKE_FILE_IN} -o $$OUT_PWD/pack_icons \
+        $$system(pkg-config --cflags --libs sdl2 SDL2_image) -lstdc++fs && \
+    $$OUT_PWD/pack_icons $$PWD/resources ${QMAKE_FILE_OUT}
+pack_icons.variable_out = HEADERS
+pack_icons.CONFIG += target_predeps no_link
+QMAKE_EXTRA_COMPILERS += pack_icons
+
+INCLUDEPATH += $$OUT_PWD
+
+# `make bundle` decodes all images below resources/ into resources/resources.bundle,
+# which the kiosk maps instead of loading the PNG files
+bundle.target = bundle
+bundle.depends = $$OUT_PWD/icon_atlas.hpp
+bundle.commands = \
+    $$QMAKE_CXX -std=c++17 -O2 -I$$OUT_PWD $$PWD/tools/pack_bundle.cpp -o $$OUT_PWD/pack_bundle \
+        $$system(pkg-config --cflags --libs sdl2 SDL2_image) -lstdc++fs && \
+    $$OUT_PWD/pack_bundle $$PWD/resources $$PWD/resources/resources.bundle
+QMAKE_EXTRA_TARGETS += bundle
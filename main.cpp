@@ -10,6 +10,12 @@
 
 #include "fontrenderer.hpp"
 #include "rendering.hpp"
+#include "damage_tracker.hpp"
+#include "transition.hpp"
+#include "mesh.hpp"
+#include "asset_manager.hpp"
+#include "startup_trace.hpp"
+#include "sprite.hpp"
 
 #include <SDL.h>
 #include <SDL_image.h>
@@ -17,12 +23,15 @@
 #include <chrono>
 #include <ctime>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <vector>
 
 using namespace std::chrono;
 
 SDL_Renderer * renderer;
 SDL_Window * window;
-SDL_Texture * home_icon;
 
 static module * current_module;
 static module * next_module;
@@ -35,12 +44,76 @@ glm::ivec2 screen_size { 1280, 1024 };
 
 std::filesystem::path resource_root;
 
+static Uint32 redraw_event = Uint32(-1);
+static std::atomic_bool redraw_pending { false };
+
+//! what has to be redrawn after a request_redraw()
+struct redraw_request
+{
+	module * source;                // whose data has changed, nullptr if unknown
+	std::optional<SDL_Rect> region; // the whole screen if not known
+};
+
+static std::mutex redraw_mutex;
+static std::vector<redraw_request> redraw_requests;
+
+// the main loop will not render more often than this, also where the renderer can't wait for vsync
+static auto constexpr frame_interval = std::chrono::microseconds(1000000 / 60);
+
+// the main loop wakes up at least once in this interval (seconds)
+static double constexpr max_idle_time = 60.0;
+
+// animations never advance more than this per frame (seconds)
+static double constexpr max_time_step = 0.1;
+
+static auto constexpr screensaver_timeout = std::chrono::minutes(5);
+
+//! wakes up the main loop to handle the redraw requests.
+static void post_redraw_event()
+{
+	if(redraw_event == Uint32(-1))
+		return;
+	if(redraw_pending.exchange(true))
+		return; // there's already a redraw event in the queue
+
+	SDL_Event ev { };
+	ev.type = redraw_event;
+	SDL_PushEvent(&ev);
+}
+
+static void push_redraw_request(redraw_request const & request)
+{
+	{
+		std::lock_guard<std::mutex> lock { redraw_mutex };
+		redraw_requests.push_back(request);
+	}
+	post_redraw_event();
+}
+
 void module::activate(module * other)
 {
+	// switching the module redraws everything anyway
 	next_module = other;
+	post_redraw_event();
+}
+
+void request_redraw()
+{
+	push_redraw_request({ nullptr, std::nullopt });
+}
+
+void request_redraw(SDL_Rect const & region)
+{
+	push_redraw_request({ nullptr, region });
+}
+
+void request_redraw(module * source)
+{
+	push_redraw_request({ source, std::nullopt });
 }
 
 static SDL_Texture * splash_icon;
+static SDL_Point splash_size;
 
 struct splash
 {
@@ -55,37 +128,58 @@ int main()
 
 	srand(time(nullptr));
 
-	if(SDL_Init(SDL_INIT_EVERYTHING) < 0)
-		die("Failed to initialize SDL: %s", SDL_GetError());
-	atexit(SDL_Quit);
-
-	if(IMG_Init(IMG_INIT_PNG) == 0)
-		die("Failed to initialize SDL_image: %s", IMG_GetError());
-	atexit(IMG_Quit);
-
-	if(TTF_Init() < 0)
-		die("Failed to initialize TTF_image: %s", TTF_GetError());
-	atexit(TTF_Quit);
-
-	window = SDL_CreateWindow(
-		"Kiosk v5.0",
-		0, 0,
-		1280, 1024,
-		SDL_WINDOW_SHOWN // SDL_WINDOW_FULLSCREEN_DESKTOP
-	);
-	if(window == nullptr)
-		die("Failed to create window: %s", SDL_GetError());
-
-	SDL_SetHintWithPriority("SDL_HINT_RENDER_VSYNC", "0", SDL_HINT_OVERRIDE);
-
-	renderer = SDL_CreateRenderer(
-		window,
-		-1, // best possible
-		SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE
-	);
-	if(renderer == nullptr)
-		die("Failed to create renderer: %s", SDL_GetError());
+	{
+		startup_trace::span const span("sdl", "SDL_Init");
+		if(SDL_Init(SDL_INIT_EVERYTHING) < 0)
+			die("Failed to initialize SDL: %s", SDL_GetError());
+		atexit(SDL_Quit);
+	}
+
+	{
+		startup_trace::span const span("sdl", "IMG_Init");
+		if(IMG_Init(IMG_INIT_PNG) == 0)
+			die("Failed to initialize SDL_image: %s", IMG_GetError());
+		atexit(IMG_Quit);
+	}
+
+	{
+		startup_trace::span const span("sdl", "TTF_Init");
+		if(TTF_Init() < 0)
+			die("Failed to initialize TTF_image: %s", TTF_GetError());
+		atexit(TTF_Quit);
+	}
+
+	redraw_event = SDL_RegisterEvents(1);
+	if(redraw_event == Uint32(-1))
+		die("Failed to register redraw event: %s", SDL_GetError());
+
+	{
+		startup_trace::span const span("sdl", "SDL_CreateWindow");
+		window = SDL_CreateWindow(
+			"Kiosk v5.0",
+			0, 0,
+			1280, 1024,
+			SDL_WINDOW_SHOWN // SDL_WINDOW_FULLSCREEN_DESKTOP
+		);
+		if(window == nullptr)
+			die("Failed to create window: %s", SDL_GetError());
+	}
+
+	{
+		startup_trace::span const span("sdl", "SDL_CreateRenderer");
+		renderer = SDL_CreateRenderer(
+			window,
+			-1, // best possible
+			// presents are paced by the display, frames are only rendered on changes anyway
+			SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE | SDL_RENDERER_PRESENTVSYNC
+		);
+		if(renderer == nullptr)
+			die("Failed to create renderer: %s", SDL_GetError());
+	}
 
+	// when the window contents are kept between frames, only the
+	// changed regions of the frontbuffer have to be presented
+	bool retained_window;
 	{
 		SDL_RendererInfo info;
 		if(SDL_GetRendererInfo(renderer, &info) < 0)
@@ -97,31 +191,35 @@ int main()
 			info.max_texture_width,
 			info.max_texture_height
 		);
+		retained_window = (info.flags & SDL_RENDERER_SOFTWARE);
 	}
 
 	SDL_ShowCursor(1);
 
-	splash_icon = IMG_LoadTexture(renderer, (resource_root / "splash.png").c_str());
-	if(splash_icon == nullptr)
-		die("Failed to load splash.png: %s", SDL_GetError());
-	SDL_SetTextureBlendMode(splash_icon, SDL_BLENDMODE_BLEND);
-
-	home_icon = IMG_LoadTexture(renderer, (resource_root / "icons" / "home.png").c_str());
-	if(home_icon == nullptr)
-		die("Failed to load home.png: %s", SDL_GetError());
-
-	// preload all resources
-	module::get<screensaver>();
-	module::get<mainmenu>();
-	module::get<lightroom>();
-	module::get<tramview>();
-	module::get<powerview>();
-	module::get<mateview>();
-	module::get<infoview>();
-	module::get<eventsview>();
-
-	// then activate screensaver as initial screen
+	// pre-decoded images, if `make bundle` was run
+	assets.open_bundle(resource_root / "resources.bundle");
+
+	// decode the images of all modules in parallel while they are initialized
+	assets.prefetch("splash.png");
+	assets.prefetch("logo.png");
+	assets.prefetch(icon_atlas::file);
+	assets.prefetch("tram/background.png");
+
+	splash_icon = assets.acquire(nullptr, "splash.png");
+	rendering::context.set_texture_blend_mode(splash_icon, SDL_BLENDMODE_BLEND);
+	SDL_QueryTexture(splash_icon, nullptr, nullptr, &splash_size.x, &splash_size.y);
+
+	// show the screensaver right away, the other modules are initialized
+	// one per main loop iteration while the kiosk is idle. The main menu
+	// and the modules it shows information from come first.
 	module::activate<screensaver>();
+	module::preload<mainmenu>();
+	module::preload<powerview>();
+	module::preload<infoview>();
+	module::preload<eventsview>();
+	module::preload<tramview>();
+	module::preload<lightroom>();
+	module::preload<mateview>();
 
 	std::vector<splash> splashes;
 
@@ -136,10 +234,16 @@ int main()
 		dy = 1024;
 
 		if(frontbuffer != nullptr)
+		{
+			rendering::context.forget(frontbuffer);
 			SDL_DestroyTexture(frontbuffer);
+		}
 
 		if(backbuffer != nullptr)
+		{
+			rendering::context.forget(backbuffer);
 			SDL_DestroyTexture(backbuffer);
+		}
 
 		frontbuffer = SDL_CreateTexture(
 			renderer,
@@ -159,38 +263,47 @@ int main()
 		if(backbuffer == nullptr)
 			die("Failed to create backbuffer: %s", SDL_GetError());
 
-		SDL_SetTextureBlendMode(frontbuffer, SDL_BLENDMODE_BLEND);
-		SDL_SetTextureBlendMode(backbuffer, SDL_BLENDMODE_BLEND);
+		rendering::context.set_texture_blend_mode(frontbuffer, SDL_BLENDMODE_BLEND);
+		rendering::context.set_texture_blend_mode(backbuffer, SDL_BLENDMODE_BLEND);
 	};
 
 	recreate_rendertargets();
 
-	rendering::big_font.emplace(
-		renderer,
-		TTF_OpenFont((resource_root / "fonts" / "Roboto-Regular.ttf" ).c_str(), 50)
-	);
-
-	rendering::medium_font.emplace(
-		renderer,
-		TTF_OpenFont((resource_root / "fonts" / "Roboto-Regular.ttf" ).c_str(), 40)
-	);
-
-	rendering::small_font.emplace(
-		renderer,
-		TTF_OpenFont((resource_root / "fonts" / "Roboto-Regular.ttf" ).c_str(), 25)
-	);
+	// redraws the damaged regions of the current module into the frontbuffer
+	auto const compose = [&]()
+	{
+		rendering::context.set_target(frontbuffer);
+		rendering::context.set_draw_color({ 0x30, 0x30, 0x30, 0xFF });
+		if(damage.everything)
+		{
+			SDL_RenderClear(renderer);
+			current_module->render();
+			rendering::batch.flush();
+		}
+		else
+		{
+			for(auto const & region : damage.regions)
+			{
+				set_redraw_region(&region);
+				rendering::context.set_draw_color({ 0x30, 0x30, 0x30, 0xFF });
+				SDL_RenderFillRect(renderer, &region);
+				current_module->render();
+			}
+			set_redraw_region(nullptr);
+		}
+	};
 
-	int pixel_transition_matrix[20][25];
-	for(auto & row  : pixel_transition_matrix)
-		for(auto & value : row)
-			value = rand() % 64;
+	rendering::fonts.open(resource_root / "fonts" / "Roboto-Regular.ttf");
+	rendering::big_font = &rendering::fonts.get(50);
+	rendering::medium_font = &rendering::fonts.get(40);
+	rendering::small_font = &rendering::fonts.get(25);
 
-	int current_transition;
+	transition * current_transition;
 	double transition_progress;
 	auto const next_transition = [&]()
 	{
-		// current_transition = rand() % 3;
-		current_transition = 1; // slider
+		// current_transition = &transition::random();
+		current_transition = &transition::get("slider");
 		transition_progress = 0.0;
 	};
 	next_transition();
@@ -198,6 +311,14 @@ int main()
 	auto const startup = high_resolution_clock::now();
 	auto last_frame = startup;
 	auto last_event = startup;
+	bool needs_redraw = true;
+	bool first_frame = true;
+	bool starting = true;
+	bool full_present = true;
+	std::vector<SDL_Rect> present_regions;
+	std::vector<SDL_Rect> overlay_regions; // drawn directly into the window
+	mesh present_quads;
+	mesh splash_quads;
 	while(next_module != nullptr)
 	{
 		int scr_x, scr_y;
@@ -214,18 +335,92 @@ int main()
 		if(current_module != next_module)
 		{
 			if(current_module != nullptr)
+			{
+				// capture the outgoing module once, the transition
+				// then reuses the snapshot in the backbuffer.
+				compose();
+				damage.clear();
 				current_module->leave();
+				std::swap(frontbuffer, backbuffer);
+			}
 			previous_module = current_module;
 			current_module = next_module;
 			transition_progress = 0.0;
 			if(current_module != nullptr)
 				current_module->enter();
+			module::invalidate();
+			needs_redraw = true;
 		}
 
+		// determine when the next frame is due, so we can sleep until then
+		auto due = high_resolution_clock::now() + duration_cast<high_resolution_clock::duration>(
+			duration<double>(std::min(current_module->next_frame(), max_idle_time))
+		);
+		if(needs_redraw or (previous_module != nullptr) or not splashes.empty() or module::preloading())
+			due = last_frame;
+		if(current_module != module::get<screensaver>())
+			due = std::min(due, last_event + screensaver_timeout);
+		due = std::max(due, last_frame + frame_interval);
+
 		SDL_Event ev;
 		bool quitting = false;
-		while(SDL_PollEvent(&ev))
+		bool has_event;
 		{
+			auto const timeout = duration_cast<milliseconds>(due - high_resolution_clock::now() + milliseconds(1));
+			if(timeout.count() > 0)
+				has_event = SDL_WaitEventTimeout(&ev, int(timeout.count()));
+			else
+				has_event = SDL_PollEvent(&ev);
+		}
+		for(; has_event; has_event = SDL_PollEvent(&ev))
+		{
+			if(ev.type == redraw_event)
+			{
+				redraw_pending = false;
+
+				std::vector<redraw_request> requests;
+				{
+					std::lock_guard<std::mutex> lock { redraw_mutex };
+					requests.swap(redraw_requests);
+				}
+				for(auto const & request : requests)
+				{
+					if(request.source != nullptr)
+					{
+						// other modules show their data when they are entered
+						if(request.source != current_module)
+							continue;
+						current_module->data_changed();
+					}
+					else if(request.region)
+					{
+						module::invalidate(*request.region);
+					}
+					else
+					{
+						// some data has changed, but we don't know where it is shown
+						module::invalidate();
+					}
+					needs_redraw = true;
+				}
+				continue;
+			}
+
+			// every other event may change what is displayed
+			needs_redraw = true;
+
+			switch(ev.type)
+			{
+				case SDL_WINDOWEVENT:
+				case SDL_RENDER_TARGETS_RESET:
+				case SDL_RENDER_DEVICE_RESET:
+					// window or render target contents may be lost
+					rendering::context.reset();
+					module::invalidate();
+					full_present = true;
+					break;
+			}
+
 			if((ev.type == SDL_MOUSEBUTTONDOWN) or (ev.type == SDL_KEYDOWN))
 				last_event = high_resolution_clock::now();
 
@@ -262,6 +457,8 @@ int main()
 			else if(previous_module == nullptr) // if no transition is in progress
 			{
 				auto const result = current_module->notify(ev);
+				if(result == success)
+					module::invalidate();
 				if(splash != nullptr)
 				{
 					if(result == failure)
@@ -270,129 +467,133 @@ int main()
 			}
 		}
 
+		// initialize the next module, unless input is waiting to be drawn
+		if(not needs_redraw)
+			module::preload_next();
+
+		// the startup is over when all modules are ready
+		if(starting and not first_frame and not module::preloading())
+		{
+			starting = false;
+			trace.finish();
+
+			// every module is initialized, so the rest is never acquired
+			assets.cancel_all();
+		}
+
 		auto const now = high_resolution_clock::now();
 
-		if(not quitting and (now - last_event) > minutes(5))
+		if(not quitting and (current_module != module::get<screensaver>()) and (now - last_event) > screensaver_timeout)
+		{
 			module::activate<screensaver>();
 
+			// nobody is waiting, keep the glyphs in case the kiosk doesn't shut down cleanly
+			rendering::fonts.save_glyphs();
+		}
+
+		if(quitting or (next_module != current_module))
+			continue;
+
+		// woken up early, but nothing to draw yet
+		if(now < due and not needs_redraw)
+			continue;
+
+		// never render faster than the frame limit
+		if(now < last_frame + frame_interval)
+			continue;
+
+		needs_redraw = false;
+
 		total_time = duration_cast<milliseconds>(now - startup).count() / 1000.0;
-		time_step = duration_cast<milliseconds>(now - last_frame).count() / 1000.0;
+		time_step = std::min(duration_cast<milliseconds>(now - last_frame).count() / 1000.0, max_time_step);
 		last_frame = now;
 
 		for(auto & sp : splashes)
 			sp.progress += time_step;
 
+		current_module->update();
+
+		// nothing has changed on the screen
+		if(damage.empty() and (previous_module == nullptr) and splashes.empty() and not full_present)
+			continue;
+
 		// Render transition
 
 		auto const start_time = high_resolution_clock::now();
+		rendering::batch.draw_calls = 0;
+		rendering::context.stats = { };
 
 		if(previous_module != nullptr)
 		{
-			SDL_SetRenderTarget(renderer, backbuffer);
-			SDL_SetRenderDrawColor(renderer, 0x30, 0x30, 0x30, 0xFF);
-			SDL_RenderClear(renderer);
-			previous_module->render();
+			// the outgoing module is already captured in the backbuffer,
+			// only the incoming module is redrawn where it has changed.
+			compose();
+			damage.clear();
 
-			SDL_SetRenderTarget(renderer, frontbuffer);
-			SDL_SetRenderDrawColor(renderer, 0x30, 0x30, 0x30, 0xFF);
+			rendering::context.set_target(nullptr);
+			rendering::context.set_draw_color({ 0xFF, 0x00, 0xFF, 0xFF });
 			SDL_RenderClear(renderer);
-			current_module->render();
 
-			SDL_SetRenderTarget(renderer, nullptr);
-			SDL_SetRenderDrawColor(renderer, 0xFF, 0x00, 0xFF, 0xFF);
-			SDL_RenderClear(renderer);
+			current_transition->render(backbuffer, frontbuffer, actual_screen, transition_progress);
+			transition_progress += current_transition->speed * time_step;
 
-			switch(current_transition)
+			if(transition_progress >= 1.0)
 			{
-				case 0: // alpha blend
-				{
-					SDL_RenderCopy(renderer, backbuffer, nullptr, &actual_screen);
-					SDL_SetTextureAlphaMod(frontbuffer, std::clamp(255.0 * pow(transition_progress, 2.0), 0.0, 255.0));
-					SDL_RenderCopy(renderer, frontbuffer, nullptr, &actual_screen);
-
-					transition_progress += 5.0 * time_step;
-					break;
-				}
-
-				case 1: // vertical sliding
-				{
-					int pos_y = screen_size.y * glm::smoothstep(0.0, 1.0, transition_progress);
-
-					SDL_Rect src_position { 0, 0, screen_size.x, pos_y };
-					SDL_Rect dst_position { actual_screen.x, actual_screen.y, screen_size.x, pos_y };
-					SDL_RenderCopy(renderer, frontbuffer, &src_position, &dst_position);
+				next_transition();
+				previous_module = nullptr;
+			}
 
-					src_position.y = src_position.h;
-					src_position.h = screen_size.y - src_position.y;
-					dst_position = { actual_screen.x + src_position.x, actual_screen.y + src_position.y, src_position.w, src_position.h };
-					SDL_RenderCopy(renderer, backbuffer, &src_position, &dst_position);
+			// the window shows both modules
+			full_present = true;
+		}
+		else
+		{
+			present_regions.clear();
+			if(damage.everything)
+				present_regions.push_back({ 0, 0, screen_size.x, screen_size.y });
+			else
+				present_regions = damage.regions;
+
+			// restore the window contents below last frame's overlays
+			for(auto const & rect : overlay_regions)
+			{
+				present_regions.push_back({
+					rect.x - actual_screen.x,
+					rect.y - actual_screen.y,
+					rect.w,
+					rect.h
+				});
+			}
 
-					dst_position.y = actual_screen.y + pos_y - 2;
-					dst_position.h = 5;
-					SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
-					SDL_RenderFillRect(renderer, &dst_position);
+			compose();
+			damage.clear();
 
-					transition_progress += 2.0 * time_step;
-					break;
-				}
+			rendering::context.set_texture_blend_mode(frontbuffer, SDL_BLENDMODE_NONE);
 
-				case 2: // pixels
+			rendering::context.set_target(nullptr);
+			if(retained_window and not full_present)
+			{
+				present_quads.clear();
+				for(auto const & rect : present_regions)
 				{
-					int const w = screen_size.x / 25;
-					int const h = screen_size.y / 20;
-
-					int progress = 64 * transition_progress;
-
-					for(int x = 0; x < 25; x++)
-					{
-						for(int y = 0; y < 20; y++)
-						{
-							SDL_Rect src_pos = {
-								w * x,
-								h * y,
-								w,
-								h
-							};
-							SDL_Rect dst_pos = {
-								actual_screen.x + src_pos.x,
-							  actual_screen.y + src_pos.y,
-							  src_pos.w,
-							  src_pos.h,
-							};
-
-							if(progress > pixel_transition_matrix[y][x])
-								SDL_RenderCopy(renderer, frontbuffer, &src_pos, &dst_pos);
-							else
-								SDL_RenderCopy(renderer, backbuffer, &src_pos, &dst_pos);
-						}
-					}
-					transition_progress += 4.5 * time_step;
-
-					break;
+					SDL_Rect const dst = { actual_screen.x + rect.x, actual_screen.y + rect.y, rect.w, rect.h };
+					present_quads.add_quad(dst, rect, { screen_size.x, screen_size.y });
 				}
+				present_quads.draw(renderer, frontbuffer);
 			}
-
-			if(transition_progress >= 1.0)
+			else
 			{
-				next_transition();
-				previous_module = nullptr;
+				rendering::context.set_draw_color({ 0xFF, 0x00, 0xFF, 0xFF });
+				SDL_RenderClear(renderer);
+				SDL_RenderCopy(renderer, frontbuffer, nullptr, &actual_screen);
+				full_present = false;
 			}
 		}
-		else
-		{
-			SDL_SetRenderTarget(renderer, frontbuffer);
-			SDL_SetRenderDrawColor(renderer, 0x30, 0x30, 0x30, 0xFF);
-			SDL_RenderClear(renderer);
-			current_module->render();
 
-			SDL_SetTextureBlendMode(frontbuffer, SDL_BLENDMODE_NONE);
-
-			SDL_SetRenderTarget(renderer, nullptr);
-			SDL_SetRenderDrawColor(renderer, 0xFF, 0x00, 0xFF, 0xFF);
-			SDL_RenderClear(renderer);
-			SDL_RenderCopy(renderer, frontbuffer, nullptr, &actual_screen);
-		}
+		overlay_regions.clear();
+		overlay_regions.push_back({ 10, 10, 150, 200 }); // debug output
 
+		splash_quads.clear();
 		for(auto const & splash : splashes)
 		{
 			int size = 100 * pow(splash.progress, 0.5);
@@ -401,16 +602,17 @@ int main()
 				splash.center.y - size/2,
 				size, size
 			};
-			int x = std::max<int>(0, 255 - 255 * pow(splash.progress, 0.5));
-			SDL_SetTextureAlphaMod(splash_icon, x);
-			SDL_SetTextureColorMod(splash_icon, splash.color.r, splash.color.g, splash.color.b);
-			SDL_RenderCopy(
-				renderer,
-				splash_icon,
-				nullptr,
-				&rekt
+			overlay_regions.push_back(rekt);
+
+			Uint8 const alpha = std::max<int>(0, 255 - 255 * pow(splash.progress, 0.5));
+			splash_quads.add_quad(
+				rekt,
+				{ 0, 0, splash_size.x, splash_size.y },
+				splash_size,
+				{ splash.color.r, splash.color.g, splash.color.b, alpha }
 			);
 		}
+		splash_quads.draw(renderer, splash_icon);
 
 		splashes.erase(
 			std::remove_if(splashes.begin(), splashes.end(), [](splash const & s) { return s.progress >= 1.0; }),
@@ -421,35 +623,54 @@ int main()
 
 		auto const frame_time = duration_cast<microseconds>(end_time - start_time).count();
 
-		rendering::small_font->render(
+		rendering::small_font->renderf(
 			{ 10, 10, 150, 50 },
-		  std::to_string(frame_time / 1000.0) + " ms",
 			FontRenderer::Left | FontRenderer::Middle,
-			{ 0xFF, 0x00, 0xFF, 0xFF }
+			{ 0xFF, 0x00, 0xFF, 0xFF },
+			"%f ms", frame_time / 1000.0
 		);
 
-		rendering::small_font->render(
+		rendering::small_font->renderf(
 			{ 10, 60, 150, 50 },
-			std::to_string(rendering::small_font->cache.size()) + ", "
-			+ std::to_string(rendering::medium_font->cache.size()) + ", "
-			+ std::to_string(rendering::big_font->cache.size()),
 			FontRenderer::Left | FontRenderer::Middle,
-			{ 0xFF, 0x00, 0xFF, 0xFF }
+			{ 0xFF, 0x00, 0xFF, 0xFF },
+			"%zu, %zu, %zu",
+			rendering::small_font->cache.size(),
+			rendering::medium_font->cache.size(),
+			rendering::big_font->cache.size()
 		);
 
+		rendering::small_font->renderf(
+			{ 10, 110, 150, 50 },
+			FontRenderer::Left | FontRenderer::Middle,
+			{ 0xFF, 0x00, 0xFF, 0xFF },
+			"%zu calls", rendering::batch.draw_calls
+		);
+
+		rendering::small_font->renderf(
+			{ 10, 160, 150, 50 },
+			FontRenderer::Left | FontRenderer::Middle,
+			{ 0xFF, 0x00, 0xFF, 0xFF },
+			"%zu saved", rendering::context.stats.saved
+		);
+
+		rendering::batch.flush();
 		SDL_RenderPresent(renderer);
 
+		if(first_frame)
+			trace.mark("first frame");
+		first_frame = false;
+
 		if(frame_time >= 16000)
 			fprintf(stdout, "%f ms\n", frame_time / 1000.0 );
 
-		rendering::big_font->collect_garbage();
-		rendering::medium_font->collect_garbage();
-		rendering::small_font->collect_garbage();
+		rendering::fonts.collect_garbage();
 	}
 
-	rendering::big_font.reset();
-	rendering::medium_font.reset();
-	rendering::small_font.reset();
+	rendering::big_font = nullptr;
+	rendering::medium_font = nullptr;
+	rendering::small_font = nullptr;
+	rendering::fonts.close();
 
 	SDL_DestroyRenderer(renderer);
 	SDL_DestroyWindow(window);
@@ -477,3 +698,13 @@ int main()
 
 	exit(1);
 }
+
+std::filesystem::path cache_directory()
+{
+	if(char const * xdg = getenv("XDG_CACHE_HOME"); xdg != nullptr and *xdg != 0)
+		return std::filesystem::path(xdg) / "shack-kiosk";
+	else if(char const * home = getenv("HOME"); home != nullptr and *home != 0)
+		return std::filesystem::path(home) / ".cache" / "shack-kiosk";
+	else
+		return { };
+}
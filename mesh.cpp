@@ -0,0 +1,55 @@
+#include "mesh.hpp"
+
+void mesh::clear()
+{
+	vertices.clear();
+	indices.clear();
+}
+
+void mesh::add_quad(SDL_Rect const & dst, SDL_Color const & color)
+{
+	add_quad(dst, { 0, 0, 1, 1 }, { 1, 1 }, color);
+}
+
+void mesh::add_quad(SDL_Rect const & dst, SDL_Rect const & src, SDL_Point tex_size, SDL_Color const & color)
+{
+	float const x0 = dst.x;
+	float const y0 = dst.y;
+	float const x1 = dst.x + dst.w;
+	float const y1 = dst.y + dst.h;
+
+	float const u0 = float(src.x) / float(tex_size.x);
+	float const v0 = float(src.y) / float(tex_size.y);
+	float const u1 = float(src.x + src.w) / float(tex_size.x);
+	float const v1 = float(src.y + src.h) / float(tex_size.y);
+
+	add_quad(
+		{ { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y1 } },
+		{ { u0, v0 }, { u1, v0 }, { u1, v1 }, { u0, v1 } },
+		color
+	);
+}
+
+void mesh::add_quad(SDL_FPoint const (&pos)[4], SDL_FPoint const (&uv)[4], SDL_Color const & color)
+{
+	int const base = int(vertices.size());
+	for(size_t i = 0; i < 4; i++)
+		vertices.push_back(SDL_Vertex { pos[i], color, uv[i] });
+
+	for(int i : { 0, 1, 2, 0, 2, 3 })
+		indices.push_back(base + i);
+}
+
+void mesh::draw(SDL_Renderer * renderer, SDL_Texture * texture) const
+{
+	if(empty())
+		return;
+	SDL_RenderGeometry(
+		renderer,
+		texture,
+		vertices.data(),
+		int(vertices.size()),
+		indices.data(),
+		int(indices.size())
+	);
+}
@@ -0,0 +1,41 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include <SDL.h>
+#include <vector>
+
+//!
+//! A list of colored, optionally textured quads that
+//! is drawn with a single SDL_RenderGeometry call.
+//!
+//! The vertex and index storage is kept between frames,
+//! so a mesh that is cleared and rebuilt every frame
+//! does not allocate in the steady state.
+//!
+struct mesh
+{
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+
+	void clear();
+
+	bool empty() const {
+		return indices.empty();
+	}
+
+	//! adds an untextured quad covering `dst`.
+	void add_quad(SDL_Rect const & dst, SDL_Color const & color);
+
+	//! adds a quad that maps the texels `src` of a texture with
+	//! the size `tex_size` onto `dst`.
+	void add_quad(SDL_Rect const & dst, SDL_Rect const & src, SDL_Point tex_size, SDL_Color const & color = { 0xFF, 0xFF, 0xFF, 0xFF });
+
+	//! adds a quad from four arbitrary corners (top left, top right,
+	//! bottom right, bottom left) with normalized texture coordinates.
+	void add_quad(SDL_FPoint const (&pos)[4], SDL_FPoint const (&uv)[4], SDL_Color const & color);
+
+	//! draws all quads with the given texture (may be nullptr).
+	void draw(SDL_Renderer * renderer, SDL_Texture * texture) const;
+};
+
+#endif // MESH_HPP
@@ -1,4 +1,9 @@
 #include "module.hpp"
+#include "damage_tracker.hpp"
+
+#include <limits>
+
+std::deque<void(*)()> module::preload_queue;
 
 module::~module()
 {
@@ -20,13 +25,52 @@ notify_result module::notify(SDL_Event const &)
 	return failure;
 }
 
+void module::update()
+{
+
+}
+
 void module::render()
 {
 
 }
 
+double module::next_frame()
+{
+	return std::numeric_limits<double>::infinity();
+}
+
 void module::leave()
 {
 
 }
 
+void module::data_changed()
+{
+	invalidate();
+}
+
+void module::invalidate()
+{
+	damage.add();
+}
+
+void module::invalidate(SDL_Rect const & region)
+{
+	damage.add(region);
+}
+
+bool module::preload_next()
+{
+	if(preload_queue.empty())
+		return false;
+	auto const init = preload_queue.front();
+	preload_queue.pop_front();
+	init();
+	return true;
+}
+
+bool module::preloading()
+{
+	return not preload_queue.empty();
+}
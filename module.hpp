@@ -2,8 +2,10 @@
 #define MODULE_HPP
 
 #include "kiosk.hpp"
+#include "startup_trace.hpp"
 #include <SDL.h>
 #include <optional>
+#include <deque>
 
 enum notify_result { failure, success };
 
@@ -20,14 +22,37 @@ struct module
 	//! called when an SDL event happens.
 	virtual notify_result notify(SDL_Event const & ev);
 
-	//! should draw the module
+	//! called once before each frame. should advance animations
+	//! and invalidate the regions of the screen that have changed.
+	virtual void update();
+
+	//! should draw the module. may be called several times per frame,
+	//! once for each region that is redrawn.
 	virtual void render();
 
+	//! returns the time in seconds until the module wants to be drawn again
+	//! without any further event happening. 0 requests continuous animation,
+	//! infinity means the module only changes on events.
+	virtual double next_frame();
+
 	//! called when the module is not shown anymore
 	virtual void leave();
 
+	//! called after request_redraw(this) while the module is shown.
+	//! should invalidate the regions that show the changed data,
+	//! by default the whole screen is invalidated.
+	virtual void data_changed();
+
+	//! marks the whole screen as changed.
+	static void invalidate();
+
+	//! marks the given region of the screen as changed.
+	static void invalidate(SDL_Rect const & region);
+
 private:
 	static void activate(module * other);
+
+	static std::deque<void(*)()> preload_queue;
 public:
 	//! Switches to the given module.
 	template<typename T>
@@ -36,6 +61,7 @@ public:
 		static std::optional<T> module;
 		if(not module)
 		{
+			startup_trace::span const span("init", typeid(T));
 			module.emplace();
 			module->init();
 		}
@@ -47,6 +73,22 @@ public:
 	{
 		activate(get<T>());
 	}
+
+	//! queues the module to be initialized by preload_next(), so
+	//! it is ready before it is first shown. Modules that are used
+	//! earlier are initialized right away by get().
+	template<typename T>
+	static void preload()
+	{
+		preload_queue.push_back([]() { get<T>(); });
+	}
+
+	//! initializes the next queued module.
+	//! returns false when the queue was empty.
+	static bool preload_next();
+
+	//! true while modules are waiting in the preload queue.
+	static bool preloading();
 };
 
 #endif // MODULE_HPP
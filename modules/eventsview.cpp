@@ -4,7 +4,6 @@
 #include "protected_value.hpp"
 #include "rect_tools.hpp"
 
-#include <thread>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <vector>
@@ -20,12 +19,12 @@ namespace
 
 	protected_value<std::vector<eventsview::Event>> events;
 
-	void fetch(http_client & client)
+	// all rows of the event list
+	SDL_Rect constexpr event_list = { 220, 10, 1050, 10 * 70 };
+
+	//! returns false if the response couldn't be used.
+	bool receive(eventsview * view, http_response && raw)
 	{
-		auto raw = client.transfer(
-			client.get,
-			"https://events-api.shackspace.de/events/"
-		);
 		if(not raw)
 		{
 			*events.obtain() = {
@@ -36,11 +35,14 @@ namespace
 						.end = std::time(nullptr),
 					}
 			};
-			return;
+			request_redraw(view);
+			return false;
 		}
+		if(raw.unchanged)
+			return true;
 		try
 		{
-			auto const json = nlohmann::json::parse(raw->begin(), raw->end());
+			auto const json = nlohmann::json::parse(raw.body.begin(), raw.body.end());
 			std::vector<eventsview::Event> list;
 
 			for(auto const & val : json)
@@ -97,32 +99,26 @@ namespace
 				list.resize(10);
 
 			*events.obtain() = std::move(list);
+			request_redraw(view);
+			return true;
 		}
 		catch(...)
 		{
-
+			return false;
 		}
 	}
 
-	[[noreturn]] void task()
+	void fetch(eventsview * view, http_client const & client)
 	{
-		http_client client;
-		client.set_headers({
-			{ "Content-Type", "application/json" },
-			{ "Access-Control-Allow-Origin", "*" },
-		});
-
-		while(true)
-		{
-			try
-			{
-				fetch(client);
-			}
-			catch (...)
-			{
+		std::string const url = "https://events-api.shackspace.de/events/";
+		client.transfer_async(
+			client.get,
+			url,
+			[view, client, url](http_response && raw) {
+				if(not receive(view, std::move(raw)))
+					client.invalidate_cache(url);
 			}
-			std::this_thread::sleep_for(std::chrono::minutes(10));
-		}
+		);
 	}
 }
 
@@ -142,7 +138,27 @@ std::optional<eventsview::Event> eventsview::current_event() const
 void eventsview::init()
 {
 	add_back_button();
-	std::thread(task).detach();
+
+	http_client client;
+	client.set_headers({
+		{ "Content-Type", "application/json" },
+		{ "Access-Control-Allow-Origin", "*" },
+	});
+	client.set_caching(true);
+	http_client::every(std::chrono::minutes(10), [this, client]() {
+		fetch(this, client);
+	});
+}
+
+void eventsview::data_changed()
+{
+	invalidate(event_list);
+}
+
+double eventsview::next_frame()
+{
+	// running events are highlighted, so check from time to time
+	return 60.0;
 }
 
 void eventsview::render()
@@ -156,48 +172,59 @@ void eventsview::render()
 	auto const now = std::time(nullptr);
 	for(auto const & ev : *events.obtain())
 	{
-		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-
+		Uint8 const alpha = odd ? 0x10 : 0x20;
 		if((std::difftime(now, ev.start) > 0) and (std::difftime(ev.end, now) < 0))
-			SDL_SetRenderDrawColor(renderer, 0x00, 0xFF, 0x00, odd ? 0x10 : 0x20);
+			rendering::batch.fill_rect(rect, { 0x00, 0xFF, 0x00, alpha });
 		else
-			SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, odd ? 0x10 : 0x20);
-		SDL_RenderFillRect(renderer, &rect);
+			rendering::batch.fill_rect(rect, { 0xFF, 0xFF, 0xFF, alpha });
 
 		auto const tm = *std::localtime(&ev.start);
 		auto const duration = std::difftime(ev.end, ev.start);
-		char buffer[256];
-		snprintf(buffer, sizeof buffer, "%02d.%02d.%04d %02d:%02d", tm.tm_mday, 1+tm.tm_mon, 1900+tm.tm_year, tm.tm_hour, tm.tm_min);
 
-		std::string duration_text;
+		int duration_value;
+		char const * duration_unit;
 		if(duration < 3600)
-			duration_text = std::to_string(int(std::ceil(duration / 60))) + " Min.";
+		{
+			duration_value = int(std::ceil(duration / 60));
+			duration_unit = "Min.";
+		}
 		else if(duration < 24 * 3600)
-			duration_text = std::to_string(int(std::ceil(duration / 3600))) + " Std.";
+		{
+			duration_value = int(std::ceil(duration / 3600));
+			duration_unit = "Std.";
+		}
 		else
-			duration_text = std::to_string(int(std::ceil(duration / (3600 * 24)))) + " Tage";
+		{
+			duration_value = int(std::ceil(duration / (3600 * 24)));
+			duration_unit = "Tage";
+		}
 
 		auto padded_rect = add_margin(rect, 10);
 
 		auto const [ text_prefix, text_postfix ] = split_horizontal(padded_rect, 100);
 
-		font.render(
+		font.renderf(
 			text_prefix,
-			duration_text,
 			font.Left | font.Middle,
-			{ 0xFF, 0xFF, 0xFF, 0x80 }
+			{ 0xFF, 0xFF, 0xFF, 0x80 },
+			"%d %s", duration_value, duration_unit
 		);
 
+		// the title ends before the date
+		int const date_width = font.measure("00.00.0000 00:00").x + 20;
+		auto const title_rect = split_horizontal(text_postfix, text_postfix.w - date_width).left;
+
 		font.render(
-			text_postfix,
+			title_rect,
 			ev.title,
-			font.Left | font.Middle
+			font.Left | font.Middle | font.Ellipsis
 		);
 
-		font.render(
+		font.renderf(
 			text_postfix,
-			buffer,
-			font.Right | font.Middle
+			font.Right | font.Middle,
+			{ 0xFF, 0xFF, 0xFF, 0xFF },
+			"%02d.%02d.%04d %02d:%02d", tm.tm_mday, 1+tm.tm_mon, 1900+tm.tm_year, tm.tm_hour, tm.tm_min
 		);
 
 		rect.y += rect.h;
@@ -21,8 +21,12 @@ struct eventsview : gui_module
 
 	void init() override;
 
+	void data_changed() override;
+
 	void render() override;
 
+	double next_frame() override;
+
 	std::optional<Event> current_event() const;
 };
 
@@ -27,14 +27,14 @@ namespace
 
 	protected_value<Muell> papiermuell, gelber_sack, restmuell;
 
-	void fetch_muell(http_client & client, protected_value<Muell> & target, std::string const & uri)
+	//! returns false if the response couldn't be used.
+	bool receive_muell(protected_value<Muell> & target, http_response const & raw)
 	{
-		auto raw = client.transfer(client.get, uri);
 		if(not raw)
-			return;
+			return false;
 		try
 		{
-			auto const json = nlohmann::json::parse(raw->begin(), raw->end());
+			auto const json = nlohmann::json::parse(raw.body.begin(), raw.body.end());
 
 			Muell muell;
 
@@ -49,36 +49,30 @@ namespace
 			muell.main_action_done = json["main_action_done"];
 
 			target.obtain() = std::move(muell);
+			return true;
 		}
 		catch(...)
 		{
-
+			return false;
 		}
 	}
 
-	[[noreturn]] void task()
+	void fetch_muell(infoview * view, http_client const & client, protected_value<Muell> & target, std::string const & uri)
 	{
-		http_client client;
-		client.set_headers({
-			{ "Content-Type", "application/json" },
-			{ "Access-Control-Allow-Origin", "*" },
-		});
-
-		while(true)
-		{
-			try
+		client.transfer_async(client.get, uri, [view, client, uri, &target](http_response && raw) {
+			if(raw.unchanged)
+				return;
+			if(not receive_muell(target, raw))
 			{
-				fetch_muell(client, gelber_sack, "http://openhab.shack/muellshack/gelber_sack");
-				fetch_muell(client, papiermuell, "http://openhab.shack/muellshack/papiermuell");
-				fetch_muell(client, restmuell,   "http://openhab.shack/muellshack/restmuell");
+				client.invalidate_cache(uri);
+				return;
 			}
-			catch (...)
-			{
-			}
-			std::this_thread::sleep_for(std::chrono::seconds(10));
-		}
+			request_redraw(view);
+		});
 	}
 
+	SDL_Rect constexpr muell_list = { 240, 30, 1030, 150 };
+
 	static bool do_alert_muell(tm const & date)
 	{
 		auto const termin = std::mktime(&const_cast<tm&>(date) );
@@ -103,12 +97,23 @@ infoview::MuellInfo infoview::get_muell_info() const
 void infoview::init()
 {
 	add_back_button();
-	std::thread(task).detach();
+
+	http_client client;
+	client.set_headers({
+		{ "Content-Type", "application/json" },
+		{ "Access-Control-Allow-Origin", "*" },
+	});
+	client.set_caching(true);
+	http_client::every(std::chrono::seconds(10), [this, client]() {
+		fetch_muell(this, client, gelber_sack, "http://openhab.shack/muellshack/gelber_sack");
+		fetch_muell(this, client, papiermuell, "http://openhab.shack/muellshack/papiermuell");
+		fetch_muell(this, client, restmuell,   "http://openhab.shack/muellshack/restmuell");
+	});
 
     {
 		auto * btn = add<button>();
 		btn->bounds = { 1100, 844, 170, 170 };
-		btn->icon = IMG_LoadTexture(renderer, (resource_root / "icons" / "campfire-mode.png" ).c_str());
+		btn->icon = get_icon(icon_atlas::campfire_mode);
 		btn->color = { 0xE6, 0x4A, 0x19, 255 };
 		btn->on_click = [=]() {
             std::thread([]() {
@@ -119,7 +124,7 @@ void infoview::init()
     {
 		auto * btn = add<button>();
 		btn->bounds = { 920, 844, 170, 170 };
-		btn->icon = IMG_LoadTexture(renderer, (resource_root / "icons" / "mii-channel.png" ).c_str());
+		btn->icon = get_icon(icon_atlas::mii_channel);
 		btn->color = { 0x85, 0xda, 0xf9, 255 };
 		btn->on_click = [=]() {
             std::thread([]() {
@@ -129,6 +134,11 @@ void infoview::init()
 	}
 }
 
+void infoview::data_changed()
+{
+	invalidate(muell_list);
+}
+
 void infoview::render()
 {
 	gui_module::render();
@@ -148,19 +158,13 @@ void infoview::render()
 
 		auto const alert = do_alert_muell(muell.date);
 
-		{
-			char buffer[256];
-			snprintf(
-				buffer, sizeof buffer,
-				"%02d.%02d.%02d",
-				muell.date.tm_mday, 1 + muell.date.tm_mon, 1900 + muell.date.tm_year
-			);
-			rendering::small_font->render(
-				date_pos,
-				buffer,
-				FontRenderer::Left | FontRenderer::Middle
-			);
-		}
+		rendering::small_font->renderf(
+			date_pos,
+			FontRenderer::Left | FontRenderer::Middle,
+			{ 0xFF, 0xFF, 0xFF, 0xFF },
+			"%02d.%02d.%02d",
+			muell.date.tm_mday, 1 + muell.date.tm_mon, 1900 + muell.date.tm_year
+		);
 
 //		if(alert)
 //		{
@@ -20,6 +20,8 @@ struct infoview : gui_module
 
 	void init() override;
 
+	void data_changed() override;
+
 	void render() override;
 
 	MuellInfo get_muell_info() const;
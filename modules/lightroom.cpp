@@ -3,122 +3,96 @@
 #include "widgets/button.hpp"
 
 #include "http_client.hpp"
+#include "rendering.hpp"
+#include "asset_manager.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <glm/glm.hpp>
-#include <thread>
-#include <mutex>
-#include <queue>
 #include <nlohmann/json.hpp>
 
-static std::mutex commands_mutex;
-static std::queue<std::tuple<int,bool>> commands;
+static http_client openhab;
 
-static void query_thread()
+//! the switches are only polled while the lightroom is shown
+static std::atomic_bool polling { false };
+
+static void query_switches()
 {
 	using nlohmann::json;
-	http_client client;
 
-	client.set_headers({
-		{ "Content-Type", "application/json" },
-		{ "Access-Control-Allow-Origin", "*" },
-	});
+	if(not polling)
+		return;
 
-	while(true)
+	auto const lroom = module::get<lightroom>();
+	for(auto & sw : lroom->switch_config)
 	{
-		auto const lroom = module::get<lightroom>();
-
-		//*/
-		for(auto & sw : lroom->switch_config)
-		{
-			auto data = client.transfer(
-				client.get,
-				"http://openhab.shack/lounge/" + std::to_string(sw.group_index)
-			);
-			if(not data)
-				continue;
-			try
+		openhab.transfer_async(
+			openhab.get,
+			"http://openhab.shack/lounge/" + std::to_string(sw.group_index),
+			[lroom, &sw](http_response && data)
 			{
-				auto cfg = json::parse(data->begin(), data->end());
-				sw.is_on = (cfg["state"] == "on");
+				if(not data)
+					return;
+				try
+				{
+					auto cfg = json::parse(data.body.begin(), data.body.end());
+					bool const is_on = (cfg["state"] == "on");
+					if(sw.is_on != is_on)
+					{
+						sw.is_on = is_on;
+						request_redraw(lroom);
+					}
+				}
+				catch(...)
+				{
+
+				}
 			}
-			catch(...)
-			{
+		);
+	}
+}
 
-			}
-		}
-		//*/
+static void send_switch(int group_index, bool is_on)
+{
+	using nlohmann::json;
+	json payload = { {  "state", is_on ? "on" : "off" } };
 
-		for(size_t i = 0; i < 100; i++)
+	openhab.transfer_async(
+		openhab.put,
+		"http://openhab.shack/lounge/" + std::to_string(group_index),
+		payload.dump(),
+		[](http_response && response)
 		{
-			if(std::lock_guard _ { commands_mutex }; not commands.empty())
-			{
-				auto cmd = commands.front();
-				json payload = { {  "state", std::get<1>(cmd) ? "on" : "off" } };
-
-				auto string = payload.dump();
-
-				auto success = client.transfer(
-					client.put,
-					"http://openhab.shack/lounge/" + std::to_string(std::get<0>(cmd)),
-					ro_buffer<const std::byte> { reinterpret_cast<std::byte const *>(string.data()), string.size() }
-				);
-				if(not success)
-					fprintf(stderr, "i failed hard.\n");
-				else
-					fprintf(stderr, "%.*s\n", success->size(), success->data());
-				fflush(stderr);
-
-				commands.pop();
-			}
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			if(not response)
+				fprintf(stderr, "i failed hard.\n");
+			else
+				fprintf(stderr, "%.*s\n", int(response.body.size()), reinterpret_cast<char const *>(response.body.data()));
+			fflush(stderr);
 		}
-	}
+	);
 }
 
-void lightroom::init()
+namespace
 {
-	add_back_button();
+	// the switches are drawn over the background
+	char const * const background_file = "lightroom/zone0000.png";
 
-	background = IMG_LoadTexture(renderer, (resource_root / "lightroom" / "zone0000.png" ).c_str());
-	foregrounds =
+	std::array const switch_files =
 	{
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "zone0001.png" ).c_str()),
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "zone0010.png" ).c_str()),
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "zone0100.png" ).c_str()),
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "zone1000.png" ).c_str()),
+	  "lightroom/switch0.png",
+	  "lightroom/switch1.png",
+	  "lightroom/switch2.png",
+	  "lightroom/switch3.png",
+	  "lightroom/switch4.png",
+	  "lightroom/switch5.png",
+	  "lightroom/switch6.png",
+	  "lightroom/switch7.png",
 	};
+}
 
-	auto const blendmode = SDL_ComposeCustomBlendMode(
-		SDL_BLENDFACTOR_SRC_ALPHA,
-		SDL_BLENDFACTOR_ONE,
-		SDL_BLENDOPERATION_MAXIMUM,
-		SDL_BLENDFACTOR_SRC_ALPHA,
-		SDL_BLENDFACTOR_ONE,
-		SDL_BLENDOPERATION_MAXIMUM
-	);
-	for(auto tex : foregrounds)
-	{
-		//if(SDL_SetTextureBlendMode(tex, blendmode) < 0)
-		//	die("%s", SDL_GetError());
-		SDL_SetTextureAlphaMod(tex, 255);
-	}
-
-	switch_background = IMG_LoadTexture(renderer, (resource_root / "lightroom" / "switches.png" ).c_str());
-
-	switches =
-	{
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "switch0.png" ).c_str()),
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "switch1.png" ).c_str()),
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "switch2.png" ).c_str()),
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "switch3.png" ).c_str()),
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "switch4.png" ).c_str()),
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "switch5.png" ).c_str()),
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "switch6.png" ).c_str()),
-	  IMG_LoadTexture(renderer, (resource_root / "lightroom" / "switch7.png" ).c_str()),
-	};
-	for(auto tex : switches)
-		SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+void lightroom::init()
+{
+	add_back_button();
 
 	switch_config =
 	{
@@ -131,7 +105,39 @@ void lightroom::init()
 	  switch_t { 2, 2, { SDL_Rect { 247, 152, 259, 114 } } }, // ganz hinten links
 	  switch_t { 2, 4, { SDL_Rect { 325, 252, 281, 138 } } }, // hinten links
 	};
-	std::thread(query_thread).detach();
+
+	openhab.set_headers({
+		{ "Content-Type", "application/json" },
+		{ "Access-Control-Allow-Origin", "*" },
+	});
+	http_client::every(std::chrono::milliseconds(100), query_switches);
+
+	// all pictures are drawn in every frame, so they are kept while the
+	// kiosk runs instead of being loaded again on every visit.
+	assets.prefetch(background_file);
+	for(auto file : switch_files)
+		assets.prefetch(file);
+
+	background = assets.acquire(this, background_file);
+	for(size_t i = 0; i < switches.size(); i++)
+		switches[i] = assets.acquire(this, switch_files[i]);
+	for(auto tex : switches)
+		rendering::context.set_texture_blend_mode(tex, SDL_BLENDMODE_BLEND);
+}
+
+void lightroom::enter()
+{
+	polling = true;
+}
+
+void lightroom::leave()
+{
+	polling = false;
+}
+
+void lightroom::data_changed()
+{
+	// update() invalidates the screen while the switches fade
 }
 
 notify_result lightroom::notify(SDL_Event const & ev)
@@ -155,10 +161,7 @@ notify_result lightroom::notify(SDL_Event const & ev)
 			any |= toggle;
 
 			if(toggle)
-			{
-				std::lock_guard _ { commands_mutex };
-				commands.emplace(sw.group_index, sw.is_on);
-			}
+				send_switch(sw.group_index, sw.is_on);
 		}
 
 		if(any)
@@ -170,36 +173,27 @@ notify_result lightroom::notify(SDL_Event const & ev)
 	return gui_module::notify(ev);
 }
 
-void lightroom::render()
+void lightroom::update()
 {
-	std::array<double, 4> blendweights = { 0, 0, 0, 0 };
+	gui_module::update();
 
 	for(auto & sw : switch_config)
 	{
-		sw.power = std::clamp(sw.power + 4.0 * (sw.is_on ? 1 : -1) * time_step, 0.0, 1.0);
-
-		blendweights[sw.bitnum] = std::max(
-			blendweights[sw.bitnum],
-			sw.power
-		);
+		auto const power = std::clamp(sw.power + 4.0 * (sw.is_on ? 1 : -1) * time_step, 0.0, 1.0);
+		if(power != sw.power)
+			invalidate(); // the switch overlays cover the whole screen
+		sw.power = power;
 	}
+}
 
+void lightroom::render()
+{
 	SDL_Rect area = { 0, 0, 1280, 1024 };
 	area.x = (screen_size.x - area.w) / 2;
 	area.y = (screen_size.y - area.h) / 2;
 
 	// Fill background with "default pattern"
-	SDL_RenderCopy(renderer, background, nullptr, &area);
-//	for(size_t i = 0; i < blendweights.size(); i++)
-//	{
-//		auto tex = foregrounds.at(i);
-//		auto const gray = uint8_t(std::clamp(255.0 * blendweights[i], 0.0, 255.0));
-//		SDL_SetTextureColorMod(tex, gray, gray, gray);
-//		SDL_RenderCopy(renderer, tex, nullptr, &area);
-//	}
-
-	// override the background image with 100% black switches
-	// SDL_RenderCopy(renderer, switch_background, nullptr, &area);
+	rendering::batch.copy(background, nullptr, area);
 
 	for(size_t i = 0; i < 8; i++)
 	{
@@ -211,10 +205,18 @@ void lightroom::render()
 		);
 		auto const map = [](float f) { return Uint8(std::clamp(255.0f * f, 0.0f, 255.0f)); };
 
-		SDL_SetTextureColorMod(switches[i], map(fcol.r), map(fcol.g), map(fcol.b));
-		SDL_RenderCopy(renderer, switches[i], nullptr, &area);
+		rendering::batch.copy(switches[i], nullptr, area, { map(fcol.r), map(fcol.g), map(fcol.b), 0xFF });
 	}
 
 	gui_module::render();
 }
 
+double lightroom::next_frame()
+{
+	for(auto const & sw : switch_config)
+	{
+		if(sw.power != (sw.is_on ? 1.0 : 0.0))
+			return 0.0; // still fading
+	}
+	return gui_module::next_frame();
+}
@@ -19,17 +19,25 @@ struct lightroom : gui_module
 	};
 
 	SDL_Texture* background;
-	std::array<SDL_Texture*, 4> foregrounds;
-	SDL_Texture * switch_background;
 	std::array<SDL_Texture*, 8> switches;
 
 	std::array<switch_t, 8> switch_config;
 
 	void init() override;
 
+	void enter() override;
+
+	void leave() override;
+
+	void data_changed() override;
+
 	notify_result notify(SDL_Event const & ev) override;
 
+	void update() override;
+
 	void render() override;
+
+	double next_frame() override;
 };
 
 #endif // LIGHTROOM_HPP
@@ -8,10 +8,10 @@
 #include "modules/eventsview.hpp"
 #include "http_client.hpp"
 #include "rendering.hpp"
+#include "damage_tracker.hpp"
 #include "rect_tools.hpp"
 #include "protected_value.hpp"
 
-#include <thread>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <vector>
@@ -41,12 +41,8 @@ namespace
 
 	protected_value<VolumioInfo> volumio;
 
-	bool update_volumio(http_client & client)
+	bool receive_volumio(http_response const & data)
 	{
-		auto data = client.transfer(
-			client.get,
-			"http://lounge.volumio.shack/api/v1/getstate"
-		);
 		if(not data)
 			return false;
 		try
@@ -76,7 +72,7 @@ namespace
 			//  "volatile":true,
 			//  "service":"volspotconnect2"
 			// }
-			auto cfg = json::parse(data->begin(), data->end());
+			auto cfg = json::parse(data.body.begin(), data.body.end());
 
 			bool changed_albumart = false;
 
@@ -105,7 +101,7 @@ namespace
 		return false;
 	}
 
-	void update_albumart(http_client & client)
+	void update_albumart(mainmenu * menu, http_client const & client)
 	{
 		std::string uri = volumio.obtain()->albumart_uri;
 		if(not uri.empty() and (uri.at(0) == '/'))
@@ -113,34 +109,52 @@ namespace
 			uri = "http://lounge.volumio.shack" + uri;
 		}
 
-		auto data = client.transfer(
-			client.get,
-			uri
-		);
+		client.transfer_async(client.get, uri, [menu](http_response && data)
+		{
+			auto info = volumio.obtain();
+			if(not data)
+				info->coverdata.clear();
+			else
+				info->coverdata = std::move(data.body);
+			info->coverart_dirty = true;
 
-		auto info = volumio.obtain();
-		if(not data)
-			info->coverdata.clear();
-		else
-			info->coverdata = *data;
-		info->coverart_dirty = true;
+			request_redraw(menu);
+		});
 	}
 
-	void update_keyholder(http_client & client)
+	void update_volumio(mainmenu * menu, http_client const & client)
 	{
-		auto data = client.transfer(
+		client.transfer_async(
 			client.get,
-			"http://portal.shack:8088/status"
+			"http://lounge.volumio.shack/api/v1/getstate",
+			[menu, client](http_response && data)
+			{
+				if(receive_volumio(data))
+					update_albumart(menu, client);
+			}
 		);
+	}
+
+	void receive_keyholder(http_response const & data)
+	{
 		if(not data)
 			return;
 		try
 		{
 			// {"status":"open","keyholder":"xq","timestamp":1558039501604}
-			auto cfg = json::parse(data->begin(), data->end());
+			auto cfg = json::parse(data.body.begin(), data.body.end());
 
 			is_open = cfg["status"] == "open";
-			keyholder.obtain() = cfg["keyholder"];
+
+			std::string holder = cfg["keyholder"];
+			if(auto current = keyholder.obtain(); *current != holder)
+			{
+				current = std::move(holder);
+				// the main menu redraws its bottom bar every second anyway,
+				// but the info view has no other reason to redraw. This
+				// happens rarely enough to redraw whatever is shown.
+				request_redraw();
+			}
 		}
 		catch(...)
 		{
@@ -148,33 +162,35 @@ namespace
 		}
 	}
 
-	[[noreturn]] void loop()
+	void update_keyholder(http_client const & client)
+	{
+		client.transfer_async(
+			client.get,
+			"http://portal.shack:8088/status",
+			receive_keyholder
+		);
+	}
+
+	void send_volumio_command(std::string const & command)
 	{
 		http_client client;
 		client.set_headers({
 			{ "Content-Type", "application/json" },
 			{ "Access-Control-Allow-Origin", "*" },
 		});
-
-		while(true)
-		{
-			update_keyholder(client);
-
-			if(update_volumio(client))
-			{
-				update_albumart(client);
-			}
-
-			std::this_thread::sleep_for(std::chrono::seconds(1));
-		}
+		client.transfer_async(
+			client.get,
+			"http://lounge.volumio.shack/api/v1/commands/?cmd=" + command,
+			nullptr
+		);
 	}
 }
 
 template<typename Target>
-static button * set(button * b, SDL_Color color, char const * file)
+static button * set(button * b, SDL_Color color, icon_atlas::icon icon)
 {
 	b->color = color;
-	b->icon = IMG_LoadTexture(renderer, (resource_root / "icons" / file).c_str());
+	b->icon = get_icon(icon);
 	b->on_click = []() {
 		module::activate<Target>();
 	};
@@ -197,48 +213,37 @@ void mainmenu::init()
 
 	SDL_Color * col = palette;
 
-	center_widgets.push_back(set<lightroom>(add<button>(), *col++, "lightbulb-on.png"));
-	center_widgets.push_back(set<tramview>(add<button>(), *col++, "tram.png"));
-	center_widgets.push_back(set<mateview>(add<button>(), *col++, "bottle-wine.png"));
-	center_widgets.push_back(set<infoview>(add<button>(), *col++, "information.png"));
+	center_widgets.push_back(set<lightroom>(add<button>(), *col++, icon_atlas::lightbulb_on));
+	center_widgets.push_back(set<tramview>(add<button>(), *col++, icon_atlas::tram));
+	center_widgets.push_back(set<mateview>(add<button>(), *col++, icon_atlas::bottle_wine));
+	center_widgets.push_back(set<infoview>(add<button>(), *col++, icon_atlas::information));
 
-	center_widgets.push_back(set<powerview>(add<button>(), *col++, "flash.png"));
+	center_widgets.push_back(set<powerview>(add<button>(), *col++, icon_atlas::flash));
 
-	center_widgets.push_back(songbutton = set<mainmenu>(add<button>(), *col++, "volume-high.png"));
+	center_widgets.push_back(songbutton = set<mainmenu>(add<button>(), *col++, icon_atlas::volume_high));
 
-	// center_widgets.push_back(set<mainmenu>(add<button>(), *col++, "cellphone-key.png"));
-	// center_widgets.push_back(set<mainmenu>(add<button>(), *col++, "alert.png"));
-	center_widgets.push_back(set<eventsview>(add<button>(), *col++, "calendar-month.png"));
+	// center_widgets.push_back(set<mainmenu>(add<button>(), *col++, icon_atlas::cellphone_key));
+	// center_widgets.push_back(set<mainmenu>(add<button>(), *col++, icon_atlas::alert));
+	center_widgets.push_back(set<eventsview>(add<button>(), *col++, icon_atlas::calendar_month));
 
 	// volumio_albumart_none = songbutton->icon;
 
-	key_icon = IMG_LoadTexture(renderer, (resource_root / "icons" / "key-variant.png" ).c_str());
-	power_icon = IMG_LoadTexture(renderer, (resource_root / "icons" / "flash.png" ).c_str());
-	skull_icon = IMG_LoadTexture(renderer, (resource_root / "icons" / "skull.png" ).c_str());
+	key_icon = get_icon(icon_atlas::key_variant);
+	power_icon = get_icon(icon_atlas::flash);
+	skull_icon = get_icon(icon_atlas::skull);
 
-	volumio_icon_song  = IMG_LoadTexture(renderer, (resource_root / "icons" / "volumio.png" ).c_str());
-	volumio_icon_artist  = IMG_LoadTexture(renderer, (resource_root / "icons" / "artist.png" ).c_str());
-	volumio_icon_album  = IMG_LoadTexture(renderer, (resource_root / "icons" / "album.png" ).c_str());
-	volumio_play  = IMG_LoadTexture(renderer, (resource_root / "icons" / "play.png" ).c_str());
-	volumio_pause = IMG_LoadTexture(renderer, (resource_root / "icons" / "pause.png" ).c_str());
-	volumio_next = IMG_LoadTexture(renderer, (resource_root / "icons" / "skip-next.png" ).c_str());
+	volumio_icon_song  = get_icon(icon_atlas::volumio);
+	volumio_icon_artist  = get_icon(icon_atlas::artist);
+	volumio_icon_album  = get_icon(icon_atlas::album);
+	volumio_play  = get_icon(icon_atlas::play);
+	volumio_pause = get_icon(icon_atlas::pause);
+	volumio_next = get_icon(icon_atlas::skip_next);
 
 	auto * nextbutton = add<button>();
 	nextbutton->bounds = { 1280 - 90, 10, 80, 80 };
 	nextbutton->icon = volumio_next;
-	nextbutton->on_click = [&]() {
-		std::thread([]()
-		{
-			http_client client;
-			client.set_headers({
-				{ "Content-Type", "application/json" },
-				{ "Access-Control-Allow-Origin", "*" },
-			});
-			client.transfer(
-				client.get,
-				"http://lounge.volumio.shack/api/v1/commands/?cmd=next"
-			);
-		}).detach();
+	nextbutton->on_click = []() {
+		send_volumio_command("next");
 	};
 
 
@@ -246,24 +251,23 @@ void mainmenu::init()
 	playpausebutton->bounds = { 1280 - 90 - 100, 10, 80, 80 };
 	playpausebutton->icon = volumio_play;
 	playpausebutton->on_click = []() {
-		std::thread([]()
-		{
-			http_client client;
-			client.set_headers({
-				{ "Content-Type", "application/json" },
-				{ "Access-Control-Allow-Origin", "*" },
-			});
-
-			std::string method = volumio.obtain()->playing ? "play" : "pause";
-
-			client.transfer(
-				client.get,
-				"http://lounge.volumio.shack/api/v1/commands/?cmd=" + method
-			);
-		}).detach();
+		send_volumio_command(volumio.obtain()->playing ? "play" : "pause");
 	};
 
-	std::thread(loop).detach();
+	http_client client;
+	client.set_headers({
+		{ "Content-Type", "application/json" },
+		{ "Access-Control-Allow-Origin", "*" },
+	});
+	http_client::every(std::chrono::seconds(1), [this, client]() {
+		update_keyholder(client);
+		update_volumio(this, client);
+	});
+}
+
+void mainmenu::data_changed()
+{
+	// update() invalidates the song button when the cover art has changed
 }
 
 void mainmenu::layout()
@@ -299,27 +303,27 @@ void mainmenu::layout()
 	}
 }
 
-void mainmenu::render()
+void mainmenu::update()
 {
+	gui_module::update();
+
 	auto timestamp = std::time(nullptr);
 	std::tm const * const clock = std::localtime(&timestamp);
 
-	module_cycle_progress += time_step;
-	while(module_cycle_progress >= 10.0)
-	{
-		module_cycle_progress -= 10.0;
-		module_cycle++;
-	}
+	module_cycle = int(total_time / 10.0);
+	module_cycle_progress = total_time - 10.0 * module_cycle;
 	modules_cycling = (module_cycle_progress <= 1.0);
 
 	bool volumio_playing;
 	{
 		auto info = volumio.obtain();
 
-		if(info->playing)
-			playpausebutton->icon = volumio_pause;
-		else
-			playpausebutton->icon = volumio_play;
+		auto const & playpause_icon = info->playing ? volumio_pause : volumio_play;
+		if(playpausebutton->icon != playpause_icon)
+		{
+			playpausebutton->icon = playpause_icon;
+			playpausebutton->invalidate();
+		}
 
 		if(info->coverart_dirty)
 		{
@@ -334,6 +338,7 @@ void mainmenu::render()
 					1
 				);
 			}
+			songbutton->invalidate();
 		}
 		info->coverart_dirty = false;
 		volumio_playing = info->playing;
@@ -354,16 +359,36 @@ void mainmenu::render()
 	}
 
 	auto const center_off = glm::ivec2(0, 100);
-	auto const center_size = screen_size - 2 * center_off;
 
 	SDL_Rect const top_bar = { 0, 0, screen_size.x, center_off.y };
 	SDL_Rect const bottom_bar = { 0, screen_size.y - center_off.y - 1, screen_size.x, center_off.y };
 
-	SDL_SetRenderDrawColor(renderer, 32, 32, 32, 255);
-	SDL_RenderFillRect(renderer, &top_bar);
+	if(modules_cycling)
+		invalidate(bottom_bar);
+
+	if(clock->tm_sec != last_second)
+	{
+		// clock, volumio info and the cover blinking change with every second
+		last_second = clock->tm_sec;
+		invalidate(top_bar);
+		invalidate(bottom_bar);
+		songbutton->invalidate();
+	}
+}
+
+void mainmenu::render()
+{
+	auto timestamp = std::time(nullptr);
+	std::tm const * const clock = std::localtime(&timestamp);
+
+	auto const center_off = glm::ivec2(0, 100);
+	auto const center_size = screen_size - 2 * center_off;
+
+	SDL_Rect const top_bar = { 0, 0, screen_size.x, center_off.y };
+	SDL_Rect const bottom_bar = { 0, screen_size.y - center_off.y - 1, screen_size.x, center_off.y };
 
-	SDL_SetRenderDrawColor(renderer, 32, 32, 32, 255);
-	SDL_RenderFillRect(renderer, &bottom_bar);
+	rendering::batch.fill_rect(top_bar, { 32, 32, 32, 255 });
+	rendering::batch.fill_rect(bottom_bar, { 32, 32, 32, 255 });
 
 	gui_module::render();
 
@@ -383,8 +408,9 @@ void mainmenu::render()
 
 	// Volumio Top Control
 	{
+		// only the shown text is copied, so the network thread isn't blocked while drawing
 		std::string text;
-		SDL_Texture * icon;
+		sprite icon;
 		{
 			auto info = volumio.obtain();
 			switch((clock->tm_sec / 4) % 3)
@@ -401,32 +427,24 @@ void mainmenu::render()
 		left.w = left.h;
 		left = add_margin(left, 10);
 
-		SDL_RenderCopy(
-			renderer,
-			icon,
-			nullptr,
-			&left
+		rendering::batch.copy(
+			icon.texture,
+			&icon.src,
+			left
 		);
 
+		// stays centered, but clear of the icon
 		rendering::big_font->render(
-			top_bar,
-			text
+			add_margin(top_bar, top_bar.h, 0),
+			text,
+			FontRenderer::Middle | FontRenderer::Center | FontRenderer::Ellipsis
 		);
 	}
 
 	for(size_t i = 0; i < bottom_modules.size(); i++)
 	{
-		SDL_SetRenderDrawColor(renderer, 32, 32, 32, 0xFF);
-		SDL_RenderFillRect(
-			renderer,
-			&bottom_modules[i]
-		);
-
-		SDL_SetRenderDrawColor(renderer, 8, 8, 8, 0xFF);
-		SDL_RenderDrawRect(
-			renderer,
-			&bottom_modules[i]
-		);
+		rendering::batch.fill_rect(bottom_modules[i], { 32, 32, 32, 0xFF });
+		rendering::batch.draw_rect(bottom_modules[i], { 8, 8, 8, 0xFF });
 	}
 
 	using module_renderer = void (mainmenu::*)(SDL_Rect);
@@ -445,7 +463,7 @@ void mainmenu::render()
 			index += std::size(renderers);
 		auto ren = renderers[size_t(index + module_cycle) % std::size(renderers)];
 
-		SDL_RenderSetClipRect(renderer, &bottom_modules[rect_id]);
+		set_clip_rect(&bottom_modules[rect_id]);
 
 		(this->*ren)(bottom_modules[rect_id]);
 	};
@@ -457,7 +475,22 @@ void mainmenu::render()
 	render_module( 3, 3);
 	render_module(-1, 4);
 
-	SDL_RenderSetClipRect(renderer, nullptr);
+	set_clip_rect(nullptr);
+}
+
+double mainmenu::next_frame()
+{
+	if(modules_cycling)
+		return 0.0;
+
+	// clock, volumio info and the cover blinking change with every second
+	auto const now = std::chrono::system_clock::now().time_since_epoch();
+	auto const fraction = now - std::chrono::duration_cast<std::chrono::seconds>(now);
+
+	return std::min(
+		1.0 - std::chrono::duration<double>(fraction).count(),
+		10.0 - module_cycle_progress
+	);
 }
 
 void mainmenu::render_power_module(SDL_Rect module_rect)
@@ -474,25 +507,25 @@ void mainmenu::render_power_module(SDL_Rect module_rect)
 
 	if(power >= 0)
 	{
-		SDL_RenderCopy(
-			renderer,
-			power_icon,
-			nullptr,
-			&left
+		rendering::batch.copy(
+			power_icon.texture,
+			&power_icon.src,
+			left
 		);
 
-		rendering::big_font->render(
+		rendering::big_font->renderf(
 			module_rect,
-			std::to_string(int(power)) + " W"
+			FontRenderer::Middle | FontRenderer::Center,
+			{ 0xFF, 0xFF, 0xFF, 0xFF },
+			"%d W", int(power)
 		);
 	}
 	else
 	{
-		SDL_RenderCopy(
-			renderer,
-			skull_icon,
-			nullptr,
-			&left
+		rendering::batch.copy(
+			skull_icon.texture,
+			&skull_icon.src,
+			left
 		);
 
 		rendering::big_font->render(
@@ -514,11 +547,10 @@ void mainmenu::render_keyholder_module(SDL_Rect module_rect)
 	name.x += module_rect.h;
 	name.w -= module_rect.h;
 
-	SDL_RenderCopy(
-		renderer,
-		key_icon,
-		nullptr,
-		&left
+	rendering::batch.copy(
+		key_icon.texture,
+		&key_icon.src,
+		left
 	);
 	{
 		rendering::big_font->render(
@@ -534,7 +566,7 @@ void mainmenu::render_trash_module(SDL_Rect module_rect)
 
 	auto const info = module::get<infoview>()->get_muell_info();
 
-	std::string what;
+	char const * what;
 	tm when;
 	switch((module_cycle / 8) % 3)
 	{
@@ -560,13 +592,11 @@ void mainmenu::render_trash_module(SDL_Rect module_rect)
 		FontRenderer::Bottom | FontRenderer::Center
 	);
 
-	char buffer[128];
-	snprintf(buffer, sizeof buffer, "%02d.%02d.%04d", when.tm_mday, 1 + when.tm_mon, 1900 + when.tm_year);
-
-	rendering::small_font->render(
+	rendering::small_font->renderf(
 		bottom,
-		buffer,
-		FontRenderer::Top | FontRenderer::Center
+		FontRenderer::Top | FontRenderer::Center,
+		{ 0xFF, 0xFF, 0xFF, 0xFF },
+		"%02d.%02d.%04d", when.tm_mday, 1 + when.tm_mon, 1900 + when.tm_year
 	);
 }
 
@@ -575,8 +605,9 @@ void mainmenu::render_event_module(SDL_Rect module_rect)
 	if(auto ev = module::get<eventsview>()->current_event(); ev)
 	{
 		rendering::big_font->render(
-			module_rect,
-			ev->title
+			add_margin(module_rect, 10, 0),
+			ev->title,
+			FontRenderer::Middle | FontRenderer::Center | FontRenderer::Ellipsis
 		);
 	}
 	else
@@ -593,12 +624,11 @@ void mainmenu::render_clock_module(SDL_Rect module_rect)
 	auto const now_t = std::time(nullptr);
 	std::tm const now = *std::localtime(&now_t);
 
-	char buffer[128];
-	snprintf(buffer, sizeof buffer, "%02d:%02d:%02d", now.tm_hour, now.tm_min, now.tm_sec);
-
-	rendering::big_font->render(
+	rendering::big_font->renderf(
 		module_rect,
-		buffer
+		FontRenderer::Middle | FontRenderer::Center,
+		{ 0xFF, 0xFF, 0xFF, 0xFF },
+		"%02d:%02d:%02d", now.tm_hour, now.tm_min, now.tm_sec
 	);
 }
 
@@ -2,6 +2,7 @@
 #define MAINMENU_HPP
 
 #include "gui_module.hpp"
+#include "sprite.hpp"
 
 struct button;
 
@@ -18,16 +19,16 @@ struct mainmenu : gui_module
 {
 	std::vector<widget*> center_widgets;
 
-	SDL_Texture * key_icon;
-	SDL_Texture * power_icon;
-	SDL_Texture * skull_icon;
+	sprite key_icon;
+	sprite power_icon;
+	sprite skull_icon;
 
-	SDL_Texture * volumio_icon_song;
-	SDL_Texture * volumio_icon_artist;
-	SDL_Texture * volumio_icon_album;
-	SDL_Texture * volumio_play;
-	SDL_Texture * volumio_pause;
-	SDL_Texture * volumio_next;
+	sprite volumio_icon_song;
+	sprite volumio_icon_artist;
+	sprite volumio_icon_album;
+	sprite volumio_play;
+	sprite volumio_pause;
+	sprite volumio_next;
 
 	button * songbutton;
 	button * playpausebutton;
@@ -38,13 +39,20 @@ struct mainmenu : gui_module
 	int module_cycle = 0;
 	bool modules_cycling = 0;
 	double module_cycle_progress = 0.0;
+	int last_second = -1;
 
 	void init() override;
 
 	void layout() override;
 
+	void update() override;
+
+	void data_changed() override;
+
 	void render() override;
 
+	double next_frame() override;
+
     static std::string get_keyholder();
 
 	void render_power_module(SDL_Rect module_rect);
@@ -1,8 +1,8 @@
 #include "mateview.hpp"
 #include "http_client.hpp"
 #include "rendering.hpp"
+#include "damage_tracker.hpp"
 
-#include <thread>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <vector>
@@ -35,58 +35,52 @@ namespace
 	  Shaft { "Mate 2",          27, { 0xfa, 0xf3, 0x5c, 0xFF } },
 	};
 
-	void fetch(http_client & client, Shaft & shaft)
+	void fetch(mateview * view, http_client const & client, Shaft & shaft)
 	{
-		auto raw = client.transfer(
+		client.transfer_async(
 			client.get,
-			"https://ora5.tutschonwieder.net/ords/lick_prod/v1/get/fuellstand/1/" + std::to_string(shaft.api_index)
-		);
-		if(not raw)
-		{
-			shaft.fill_level_available = false;
-			return;
-		}
-		try
-		{
-			auto const json = nlohmann::json::parse(raw->begin(), raw->end());
-			shaft.fill_level = json["fuellstand"];
-			shaft.fill_level_available = true;
-		}
-		catch(...)
-		{
-			shaft.fill_level_available = false;
-		}
-	}
-
-	[[noreturn]] void task()
-	{
-		http_client client;
-		client.set_headers({
-			{ "Content-Type", "application/json" },
-			{ "Access-Control-Allow-Origin", "*" },
-		});
-
-		while(true)
-		{
-			try
+			"https://ora5.tutschonwieder.net/ords/lick_prod/v1/get/fuellstand/1/" + std::to_string(shaft.api_index),
+			[view, &shaft](http_response && raw)
 			{
-				for(size_t i = 0; i < shafts.size(); i++)
+				bool const was_available = shaft.fill_level_available;
+				int const last_level = shaft.fill_level;
+				if(not raw)
 				{
-					fetch(client, shafts[i]);
+					shaft.fill_level_available = false;
 				}
+				else try
+				{
+					auto const json = nlohmann::json::parse(raw.body.begin(), raw.body.end());
+					shaft.fill_level = json["fuellstand"];
+					shaft.fill_level_available = true;
+				}
+				catch(...)
+				{
+					shaft.fill_level_available = false;
+				}
+				// the chart covers most of the screen, so only redraw on changes
+				if(shaft.fill_level_available != was_available or shaft.fill_level != last_level)
+					request_redraw(view);
 			}
-			catch (...)
-			{
-			}
-			std::this_thread::sleep_for(std::chrono::seconds(10));
-		}
+		);
 	}
 }
 
 void mateview::init()
 {
 	add_back_button();
-	std::thread(task).detach();
+
+	http_client client;
+	client.set_headers({
+		{ "Content-Type", "application/json" },
+		{ "Access-Control-Allow-Origin", "*" },
+	});
+
+	// all shafts are queried at the same time
+	http_client::every(std::chrono::seconds(10), [this, client]() {
+		for(auto & shaft : shafts)
+			fetch(this, client, shaft);
+	});
 }
 
 void mateview::render()
@@ -96,8 +90,7 @@ void mateview::render()
 
 	SDL_Rect const window = { 220, 20, 1040, 840 };
 
-	SDL_SetRenderDrawColor(renderer, 32, 32, 32, 255);
-	SDL_RenderFillRect(renderer, &window);
+	rendering::batch.fill_rect(window, { 32, 32, 32, 255 });
 
 	auto const get_column_rect = [&](size_t idx) -> SDL_Rect
 	{
@@ -115,7 +108,7 @@ void mateview::render()
 
 	// Draw diagram
 	{
-		SDL_RenderSetClipRect(renderer, &window);
+		set_clip_rect(&window);
 
 		int const max_fill_level = 200;
 		auto const & font = *rendering::medium_font;
@@ -129,11 +122,11 @@ void mateview::render()
 			full_column.h = (full_column.h * shaft.fill_level) / max_fill_level;
 			full_column.y = window.y + window.h - full_column.h;
 
-			SDL_SetRenderDrawColor(renderer, shaft.color.r, shaft.color.g, shaft.color.b, shaft.color.a);
-			SDL_RenderFillRect(renderer, &full_column);
-
-			SDL_SetRenderDrawColor(renderer, shaft.color.r/2, shaft.color.g/2, shaft.color.b/2, shaft.color.a);
-			SDL_RenderDrawRect(renderer, &full_column);
+			rendering::batch.fill_rect(full_column, shaft.color);
+			rendering::batch.draw_rect(
+				full_column,
+				{ Uint8(shaft.color.r/2), Uint8(shaft.color.g/2), Uint8(shaft.color.b/2), shaft.color.a }
+			);
 
 			SDL_Rect column_label;
 			int alignment;
@@ -153,15 +146,16 @@ void mateview::render()
 				alignment = FontRenderer::Bottom | FontRenderer::Center;
 			}
 
-			font.render(
+			font.renderf(
 				column_label,
-				std::to_string(shafts[i].fill_level),
-				alignment
+				alignment,
+				{ 0xFF, 0xFF, 0xFF, 0xFF },
+				"%d", int(shafts[i].fill_level)
 			);
 		}
 	}
 
-	SDL_RenderSetClipRect(renderer, nullptr);
+	set_clip_rect(nullptr);
 
 	// Draw labels
 	{
@@ -184,11 +178,10 @@ void mateview::render()
 			};
 			SDL_Point const center = { dest.w, dest.h / 2 };
 
-			SDL_RenderCopyEx(
-				renderer,
+			rendering::batch.copy_ex(
 				text.texture.get(),
 				nullptr,
-				&dest,
+				dest,
 				-45,
 				&center,
 				SDL_FLIP_NONE
@@ -3,13 +3,15 @@
 #include "widgets/button.hpp"
 #include "protected_value.hpp"
 #include "rendering.hpp"
+#include "damage_tracker.hpp"
+#include "json_stream.hpp"
 
-#include <thread>
 #include <mutex>
-#include <nlohmann/json.hpp>
 #include <vector>
 #include <atomic>
 #include <iomanip>
+#include <algorithm>
+#include <cmath>
 
 namespace /* static */
 {
@@ -62,11 +64,14 @@ namespace /* static */
 
 namespace /* static */
 {
-	std::atomic_flag fast_reload;
 	std::atomic_int scroll_progress;
 
 	int zoom_level = 2;
 
+	//! counts the queries, only the response of the latest one is shown,
+	//! so a query still running from before a zoom can't replace the new range
+	std::atomic_int query_generation { 0 };
+
 	struct zoomscale
 	{
 		int value;
@@ -111,92 +116,204 @@ namespace /* static */
 
 	protected_value<std::vector<powernode>> nodes;
 
-	[[noreturn]] static void query_thread()
+	// storage for the graph, kept between frames
+	std::array<std::vector<SDL_Point>, 4> graph_lines;
+
+	http_client influx;
+	int failcounter = 0;
+
+	//! collects the rows of the influx response while it's received.
+	//!
+	//! The response holds one result per phase, each with a single series:
+	//! {"results":[{"series":[{"values":[["<time>",<power>],...]}]},...]}
+	//! The rows of the first result create the nodes, the other two
+	//! results fill in the power of their phase.
+	struct influx_reader : json_handler
 	{
-		using nlohmann::json;
-		http_client client;
+		json_stream parser { *this };
 
-		client.set_headers({
-			{ "Content-Type", "application/json" },
-			{ "Access-Control-Allow-Origin", "*" },
-		});
+		std::vector<powernode> nodes;
+		size_t rows[3] = { 0, 0, 0 }; // received rows per phase
 
-		int failcounter = 0;
-		while(true)
-		{
-			auto level = zoom_scale[zoom_level];
+		int depth = 0;
+		std::string last_key;
+		bool in_results = false, in_series = false, in_values = false;
+		int result = -1; // index in "results"
+		int series = -1; // index in "series" of the current result
+		int column = 0;  // in the current row
+		powernode * row = nullptr; // target of the current row
 
-			std::string time_range = std::to_string(level.value) + "s";
+		bool key(std::string_view name) override
+		{
+			last_key = name;
+			return true;
+		}
 
-			std::string time_step = std::to_string(std::max(1, level.value / 1000)) + "s";
+		bool start_object() override
+		{
+			depth++;
+			if(in_results and depth == 3)
+			{
+				result++;
+				series = -1;
+			}
+			if(in_series and depth == 5)
+				series++;
+			return true;
+		}
 
-			std::string const msg = "http://influx.shack/query?pretty=false&db=telegraf&q=" +
-				urlencode(
-					"SELECT mean(\"value\") FROM \"Power\" WHERE (\"topic\" = '/power/total/L1/Power') AND time >= now() - " + time_range + " GROUP BY time(" + time_step + ") fill(null);"
-					"SELECT mean(\"value\") FROM \"Power\" WHERE (\"topic\" = '/power/total/L2/Power') AND time >= now() - " + time_range + " GROUP BY time(" + time_step + ") fill(null);"
-					"SELECT mean(\"value\") FROM \"Power\" WHERE (\"topic\" = '/power/total/L3/Power') AND time >= now() - " + time_range + " GROUP BY time(" + time_step + ") fill(null)"
-			);
+		bool end_object() override
+		{
+			depth--;
+			return true;
+		}
 
-			auto data = client.transfer(client.get, msg);
+		bool start_array() override
+		{
+			depth++;
+			if(depth == 2 and last_key == "results")
+				in_results = true;
+			else if(in_results and depth == 4 and last_key == "series")
+				in_series = true;
+			else if(in_series and series == 0 and depth == 6 and last_key == "values")
+				in_values = true;
+			else if(in_values and depth == 7 and result >= 0 and result < 3)
+				start_row();
+			return true;
+		}
 
-			if(not data)
+		bool end_array() override
+		{
+			switch(depth--)
 			{
-				// server not reachable, ignore and try again
-				std::this_thread::sleep_for(std::chrono::seconds(10));
+				case 2: in_results = false; break;
+				case 4: in_series = false; break;
+				case 6: in_values = false; break;
+				case 7: row = nullptr; break;
+			}
+			return true;
+		}
 
-				continue;
+		void start_row()
+		{
+			size_t const index = rows[result]++;
+			column = 0;
+			if(result == 0)
+			{
+				// incomplete until the time and all phases are known
+				row = &nodes.emplace_back();
+				row->phase[0] = row->phase[1] = row->phase[2] = std::nan("");
+				row->time.tm_year = -1;
 			}
-			try
+			else if(index < nodes.size())
 			{
-				auto cfg = json::parse(data->begin(), data->end());
-
-				auto results = cfg["results"];
-
-				auto l1 = results[0]["series"][0]["values"];
-				auto l2 = results[1]["series"][0]["values"];
-				auto l3 = results[2]["series"][0]["values"];
-
-				if(l1.size() != l2.size())
-					continue;
-				if(l1.size() != l3.size())
-					continue;
-
-				std::vector<powernode> new_nodes;
-				for(size_t i = 0; i < l1.size(); i++)
-				{
-					auto & node = new_nodes.emplace_back();
-					try {
-						node.time = parse_timestamp(l1[i][0].get<string>());
-						node.phase[0] = l1[i][1].get<double>();
-						node.phase[1] = l2[i][1].get<double>();
-						node.phase[2] = l3[i][1].get<double>();
-					} catch(...) {
-						new_nodes.erase(new_nodes.end() - 1);
-					}
-				}
-
-				if(new_nodes.size() > 0)
-				  module::get<powerview>()->total_power = new_nodes.back().total();
-
-				*nodes.obtain() = std::move(new_nodes);
-
-				failcounter = 0;
+				row = &nodes[index];
 			}
-			catch(...)
+			else
 			{
-				failcounter++;
-				if(failcounter >= 10) {
-					module::get<powerview>()->total_power = -1.0;
-				}
+				row = nullptr;
 			}
+		}
 
-			fast_reload.test_and_set(); // make sure we have "set"
-			for(size_t i = 0; i < 50 and fast_reload.test_and_set(); i++)
-			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		bool string(std::string_view text) override
+		{
+			if(row != nullptr and column == 0 and result == 0)
+				row->time = parse_timestamp(std::string(text));
+			column++;
+			return true;
+		}
+
+		bool number(double value) override
+		{
+			if(row != nullptr and column == 1)
+				row->phase[result] = value;
+			column++;
+			return true;
+		}
+
+		bool null() override
+		{
+			column++;
+			return true;
+		}
+
+		bool boolean(bool) override
+		{
+			column++;
+			return true;
+		}
+	};
+
+	void receive(influx_reader & reader, http_response && data)
+	{
+		if(not data and not reader.parser.failed())
+			return; // server not reachable, ignore and try again
+
+		// influx reports errors as JSON without results, which
+		// must not replace the nodes with an empty list
+		if(data.status == 200 and reader.parser.finish())
+		{
+			if(reader.rows[0] != reader.rows[1])
+				return;
+			if(reader.rows[0] != reader.rows[2])
+				return;
+
+			auto & new_nodes = reader.nodes;
+			new_nodes.erase(
+				std::remove_if(new_nodes.begin(), new_nodes.end(), [](powernode const & node) {
+					return node.time.tm_year < 0 or std::isnan(node.total());
+				}),
+				new_nodes.end()
+			);
+
+			if(new_nodes.size() > 0)
+			  module::get<powerview>()->total_power = new_nodes.back().total();
+
+			*nodes.obtain() = std::move(new_nodes);
+			request_redraw(module::get<powerview>());
+
+			failcounter = 0;
+		}
+		else
+		{
+			failcounter++;
+			if(failcounter >= 10) {
+				module::get<powerview>()->total_power = -1.0;
+				request_redraw(module::get<powerview>());
 			}
 		}
 	}
+
+	void query()
+	{
+		auto level = zoom_scale[zoom_level];
+
+		std::string time_range = std::to_string(level.value) + "s";
+
+		std::string time_step = std::to_string(std::max(1, level.value / 1000)) + "s";
+
+		std::string const msg = "http://influx.shack/query?pretty=false&db=telegraf&q=" +
+			urlencode(
+				"SELECT mean(\"value\") FROM \"Power\" WHERE (\"topic\" = '/power/total/L1/Power') AND time >= now() - " + time_range + " GROUP BY time(" + time_step + ") fill(null);"
+				"SELECT mean(\"value\") FROM \"Power\" WHERE (\"topic\" = '/power/total/L2/Power') AND time >= now() - " + time_range + " GROUP BY time(" + time_step + ") fill(null);"
+				"SELECT mean(\"value\") FROM \"Power\" WHERE (\"topic\" = '/power/total/L3/Power') AND time >= now() - " + time_range + " GROUP BY time(" + time_step + ") fill(null)"
+		);
+
+		// the rows are parsed while the response is still received
+		auto reader = std::make_shared<influx_reader>();
+		int const generation = ++query_generation;
+		influx.stream_async(
+			msg,
+			[reader](ro_buffer<const std::byte> chunk) {
+				return reader->parser.feed({ reinterpret_cast<char const *>(chunk.data()), chunk.size() });
+			},
+			[reader, generation](http_response && data) {
+				if(generation != query_generation)
+					return; // superseded by a newer query
+				receive(*reader, std::move(data));
+			}
+		);
+	}
 }
 
 void powerview::init()
@@ -206,29 +323,33 @@ void powerview::init()
 	{
 		auto * btn = add<button>();
 		btn->bounds = { 30, 824, 170, 170 };
-		btn->icon = IMG_LoadTexture(renderer, (resource_root / "icons" / "magnify-plus-outline.png" ).c_str());
+		btn->icon = get_icon(icon_atlas::magnify_plus_outline);
 		btn->color = { 0x03, 0xA9, 0xF4, 255 };
 		btn->on_click = []() {
 			/* zoom in */
 			if(zoom_level > 0)
 				zoom_level--;
-			fast_reload.clear();
+			query();
 		};
 	}
 	{
 		auto * btn = add<button>();
 		btn->bounds = { 30, 624, 170, 170 };
-		btn->icon = IMG_LoadTexture(renderer, (resource_root / "icons" / "magnify-minus-outline.png" ).c_str());
+		btn->icon = get_icon(icon_atlas::magnify_minus_outline);
 		btn->color = { 0x03, 0xA9, 0xF4, 255 };
 		btn->on_click = [=]() {
 			/* zoom out */
 			if(zoom_level < (zoom_scale_cnt - 1))
 				zoom_level++;
-			fast_reload.clear();
+			query();
 		};
 	}
 
-	std::thread(query_thread).detach();
+	influx.set_headers({
+		{ "Content-Type", "application/json" },
+		{ "Access-Control-Allow-Origin", "*" },
+	});
+	http_client::every(std::chrono::seconds(5), query);
 }
 
 void powerview::render()
@@ -240,8 +361,7 @@ void powerview::render()
 
 	SDL_Rect const window = { 220, 20, 1040, 984 };
 
-	SDL_SetRenderDrawColor(renderer, 32, 32, 32, 255);
-	SDL_RenderFillRect(renderer, &window);
+	rendering::batch.fill_rect(window, { 32, 32, 32, 255 });
 
 	double max = 0;
 	for(size_t i = 0; i < nodes->size(); i++)
@@ -262,37 +382,32 @@ void powerview::render()
 		};
 	};
 
-	SDL_RenderSetClipRect(renderer, &window);
+	set_clip_rect(&window);
 
-	for(size_t i = 1; i < nodes->size(); i++)
-	{
-		auto const & from = nodes->at(i - 1);
-		auto const & to   = nodes->at(i - 0);
+	// one line strip per phase and one for the total
+	for(auto & line : graph_lines)
+		line.clear();
 
+	for(size_t i = 0; i < nodes->size(); i++)
+	{
+		auto const & node = nodes->at(i);
 		for(size_t j = 0; j < 3; j++)
-		{
-			SDL_SetRenderDrawColor(renderer, (j==0)?255:0, (j==1)?255:0, (j==2)?255:0, 255);
-
-			auto const p1 = get_point(i - 1, from.phase[j]);
-			auto const p2 = get_point(i, to.phase[j]);
-			SDL_RenderDrawLine(renderer,
-				p1.x, p1.y,
-				p2.x, p2.y
-			);
-		}
-		{
-			SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+			graph_lines[j].push_back(get_point(i, node.phase[j]));
+		graph_lines[3].push_back(get_point(i, node.total()));
+	}
 
-			auto const p1 = get_point(i - 1, from.total());
-			auto const p2 = get_point(i, to.total());
-			SDL_RenderDrawLine(renderer,
-				p1.x, p1.y,
-				p2.x, p2.y
-			);
-		}
+	for(size_t j = 0; j < graph_lines.size(); j++)
+	{
+		SDL_Color const color = {
+			Uint8((j==0 or j==3)?255:0),
+			Uint8((j==1 or j==3)?255:0),
+			Uint8((j==2 or j==3)?255:0),
+			255
+		};
+		rendering::batch.draw_lines(graph_lines[j].data(), graph_lines[j].size(), color);
 	}
 
-	SDL_RenderSetClipRect(renderer, nullptr);
+	set_clip_rect(nullptr);
 
 	{
 		int h = TTF_FontHeight(rendering::small_font->font.get());
@@ -301,14 +416,13 @@ void powerview::render()
 		{
 			rect = { 240, int(get_point(0, 1000.0 * i).y - h/2), 65, h };
 
-			SDL_SetRenderDrawColor(renderer, 32, 32, 32, 0x80);
-			SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-			SDL_RenderFillRect(renderer, &rect);
+			rendering::batch.fill_rect(rect, { 32, 32, 32, 0x80 });
 
-			rendering::small_font->render(
+			rendering::small_font->renderf(
 				rect,
-				std::to_string(1000 * i),
-				FontRenderer::Middle | FontRenderer::Left
+				FontRenderer::Middle | FontRenderer::Left,
+				{ 0xFF, 0xFF, 0xFF, 0xFF },
+				"%d", 1000 * i
 			);
 		}
 	}
@@ -332,10 +446,11 @@ void powerview::render()
 		);
 		rect.y += TTF_FontHeight(rendering::small_font->font.get());
 
-		rendering::big_font->render(
+		rendering::big_font->renderf(
 			rect,
-			std::to_string(int(nodes->back().total())) + " W",
-			FontRenderer::Center | FontRenderer::Top
+			FontRenderer::Center | FontRenderer::Top,
+			{ 0xFF, 0xFF, 0xFF, 0xFF },
+			"%d W", int(nodes->back().total())
 		);
 		rect.y += rect.h;
 
@@ -347,11 +462,11 @@ void powerview::render()
 		);
 		rect.y += TTF_FontHeight(rendering::small_font->font.get());
 
-		rendering::big_font->render(
+		rendering::big_font->renderf(
 			rect,
-			std::to_string(int(nodes->back().phase[0])) + " W",
 			FontRenderer::Center | FontRenderer::Top,
-			{ 0xFF, 0x00, 0x00, 0xFF }
+			{ 0xFF, 0x00, 0x00, 0xFF },
+			"%d W", int(nodes->back().phase[0])
 		);
 		rect.y += rect.h;
 
@@ -364,11 +479,11 @@ void powerview::render()
 		);
 		rect.y += TTF_FontHeight(rendering::small_font->font.get());
 
-		rendering::big_font->render(
+		rendering::big_font->renderf(
 			rect,
-			std::to_string(int(nodes->back().phase[1])) + " W",
 			FontRenderer::Center | FontRenderer::Top,
-			{ 0x00, 0xFF, 0x00, 0xFF }
+			{ 0x00, 0xFF, 0x00, 0xFF },
+			"%d W", int(nodes->back().phase[1])
 		);
 		rect.y += rect.h;
 
@@ -380,11 +495,11 @@ void powerview::render()
 		);
 		rect.y += TTF_FontHeight(rendering::small_font->font.get());
 
-		rendering::big_font->render(
+		rendering::big_font->renderf(
 			rect,
-			std::to_string(int(nodes->back().phase[2])) + " W",
 			FontRenderer::Center | FontRenderer::Top,
-			{ 0x00, 0x00, 0xFF, 0xFF }
+			{ 0x00, 0x00, 0xFF, 0xFF },
+			"%d W", int(nodes->back().phase[2])
 		);
 	}
 }
@@ -1,15 +1,13 @@
 #include "screensaver.hpp"
 #include "mainmenu.hpp"
+#include "rendering.hpp"
+#include "asset_manager.hpp"
 
 double constexpr PI = 3.1415;
 
 void screensaver::init()
 {
-	logo = IMG_LoadTexture(
-		renderer,
-		(resource_root / "logo.png").c_str()
-	);
-	assert(logo != nullptr);
+	logo = assets.acquire(this, "logo.png");
 
 	next_effect();
 }
@@ -25,6 +23,11 @@ void screensaver::enter()
 	timer = 8.0;
 }
 
+double screensaver::next_frame()
+{
+	return 0.0; // always animated
+}
+
 notify_result screensaver::notify(SDL_Event const & ev)
 {
 	if(ev.type == SDL_MOUSEBUTTONDOWN)
@@ -36,20 +39,22 @@ notify_result screensaver::notify(SDL_Event const & ev)
 	return failure;
 }
 
-void screensaver::render()
+void screensaver::update()
 {
 	timer += time_step;
-
-	double t = timer; // 10 sekunden
-	if(t >= 10.0)
+	if(timer >= 10.0) // 10 sekunden
 	{
-		t -= 10.0;
 		timer -= 10.0;
 		next_effect();
 	}
+	invalidate();
+}
+
+void screensaver::render()
+{
+	double t = timer;
 
-	SDL_SetRenderDrawColor(renderer, 0,0,0,255);
-	SDL_RenderClear(renderer);
+	rendering::batch.fill_rect({ 0, 0, screen_size.x, screen_size.y }, { 0, 0, 0, 255 });
 
 	SDL_Rect rect = {0, 0, 1146, 500 };
 	rect.x = (screen_size.x - rect.w) / 2;
@@ -208,11 +213,10 @@ void screensaver::render()
 					srcrect.x = 0;
 					srcrect.y = i;
 
-					SDL_RenderCopy(
-						renderer,
+					rendering::batch.copy(
 						logo,
 						&srcrect,
-						&dstrect
+						dstrect
 					);
 				}
 				return; // IMPORTANT
@@ -224,11 +228,10 @@ void screensaver::render()
 		}
 	}
 
-	SDL_RenderCopyEx(
-		renderer,
+	rendering::batch.copy_ex(
 		logo,
 		nullptr,
-		&rect,
+		rect,
 		rot,
 		&rot_point,
 		SDL_RendererFlip(flip)
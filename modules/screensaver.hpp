@@ -21,8 +21,12 @@ struct screensaver : module
 
 	void enter() override;
 
+	void update() override;
+
 	void render() override;
 
+	double next_frame() override;
+
 	notify_result notify(SDL_Event const & ev) override;
 };
 
@@ -1,9 +1,9 @@
 #include "tramview.hpp"
 #include "http_client.hpp"
 #include "rendering.hpp"
+#include "asset_manager.hpp"
 #include "protected_value.hpp"
 
-#include <thread>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <vector>
@@ -31,20 +31,19 @@ namespace
 
 	protected_value<std::vector<Departure>> departures;
 
-	void fetch(http_client & client)
+	//! returns false if the response couldn't be used.
+	bool receive(tramview * view, http_response && raw)
 	{
-		auto raw = client.transfer(
-			client.get,
-			"https://efa-api.asw.io/api/v1/station/5000082/departures/?format=json"
-		);
 		if(not raw)
 		{
 			data_available = false;
-			return;
+			return false;
 		}
+		if(raw.unchanged)
+			return true;
 		try
 		{
-			auto const json = nlohmann::json::parse(raw->begin(), raw->end());
+			auto const json = nlohmann::json::parse(raw.body.begin(), raw.body.end());
 
 			std::vector<Departure> data;
 			for(auto const & src : json)
@@ -103,32 +102,27 @@ namespace
 
 			*departures.obtain() = std::move(data);
 			data_available = true;
+			request_redraw(view);
+			return true;
 		}
 		catch(...)
 		{
 			data_available = false;
+			return false;
 		}
 	}
 
-	[[noreturn]] void task()
+	void fetch(tramview * view, http_client const & client)
 	{
-		http_client client;
-		client.set_headers({
-			{ "Content-Type", "application/json" },
-			{ "Access-Control-Allow-Origin", "*" },
-		});
-
-		while(true)
-		{
-			try
-			{
-				fetch(client);
-			}
-			catch (...)
-			{
+		std::string const url = "https://efa-api.asw.io/api/v1/station/5000082/departures/?format=json";
+		client.transfer_async(
+			client.get,
+			url,
+			[view, client, url](http_response && raw) {
+				if(not receive(view, std::move(raw)))
+					client.invalidate_cache(url);
 			}
-			std::this_thread::sleep_for(std::chrono::seconds(10));
-		}
+		);
 	}
 }
 
@@ -136,22 +130,54 @@ void tramview::init()
 {
 	add_back_button();
 
-	background = IMG_LoadTexture(renderer, (resource_root / "tram" / "background.png").c_str());
-	assert(background != nullptr);
+	background = assets.acquire(this, "tram/background.png");
+
+	route_icons[0] = get_icon(icon_atlas::tram_U4);
+	route_icons[1] = get_icon(icon_atlas::tram_U9);
+	route_icons[2] = get_icon(icon_atlas::tram_N1);
+	route_icons[3] = get_icon(icon_atlas::tram_N2);
+	route_icons[4] = get_icon(icon_atlas::tram_N6);
+	route_icons[5] = get_icon(icon_atlas::tram_N7);
+
+	http_client client;
+	client.set_headers({
+		{ "Content-Type", "application/json" },
+		{ "Access-Control-Allow-Origin", "*" },
+	});
+	client.set_caching(true);
+	http_client::every(std::chrono::seconds(10), [this, client]() {
+		fetch(this, client);
+	});
+}
+
+namespace
+{
+	// first rows of the departure lists
+	SDL_Rect constexpr to_city_list   = { 620, 300, 600, 50 };
+	SDL_Rect constexpr from_city_list = {  90, 680, 600, 50 };
+	int constexpr list_length = 4;
+}
+
+void tramview::update()
+{
+	gui_module::update();
 
-	route_icons[0] = IMG_LoadTexture(renderer, (resource_root / "tram" / "U4.png").c_str());
-	route_icons[1] = IMG_LoadTexture(renderer, (resource_root / "tram" / "U9.png").c_str());
-	route_icons[2] = IMG_LoadTexture(renderer, (resource_root / "tram" / "N1.png").c_str());
-	route_icons[3] = IMG_LoadTexture(renderer, (resource_root / "tram" / "N2.png").c_str());
-	route_icons[4] = IMG_LoadTexture(renderer, (resource_root / "tram" / "N6.png").c_str());
-	route_icons[5] = IMG_LoadTexture(renderer, (resource_root / "tram" / "N7.png").c_str());
+	// the minute counters run down and imminent departures pulse
+	data_changed();
+}
 
-	std::thread(task).detach();
+void tramview::data_changed()
+{
+	for(auto rect : { to_city_list, from_city_list })
+	{
+		rect.h *= list_length;
+		invalidate(rect);
+	}
 }
 
 void tramview::render()
 {
-	SDL_RenderCopy(renderer, background, nullptr, nullptr);
+	rendering::batch.copy(background, nullptr, { 0, 0, screen_size.x, screen_size.y });
 
 	gui_module::render();
 
@@ -191,10 +217,12 @@ void tramview::render()
 
 	std::array<Lists, 2> lists =
 	{
-	  Lists { { 620, 300, 600, 50 } }, // to city
-	  Lists { { 90, 680, 600, 50 } }, // from city
+	  Lists { to_city_list }, // to city
+	  Lists { from_city_list }, // from city
 	};
 
+	departure_imminent = false;
+
 	auto view = departures.obtain();
 	for(auto const & dep : *view)
 	{
@@ -214,18 +242,16 @@ void tramview::render()
 			default:
 				continue;
 		}
-		if(list->counter >= 4)
+		if(list->counter >= list_length)
 			continue;
 
-		SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xC0);
-		SDL_RenderFillRect(renderer, &list->background);
+		rendering::batch.fill_rect(list->background, { 0xFF, 0xFF, 0xFF, 0xC0 });
 
-		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-		SDL_RenderCopy(
-			renderer,
-			route_icons[dep.route - 1],
-			nullptr,
-			&list->icon
+		auto const & icon = route_icons[dep.route - 1];
+		rendering::batch.copy(
+			icon.texture,
+			&icon.src,
+			list->icon
 		);
 
 		rendering::small_font->render(
@@ -235,18 +261,41 @@ void tramview::render()
 			{ 0,0,0,255 }
 		);
 
-		Uint8 r = 0;
+		int const minutes = int(std::floor(time_diff / 60.0));
 		if(time_diff <= 360) // JETZT ABER SCHNELL
-			r = 160 + 95 * sin(4.0 * total_time);
-
-		rendering::small_font->render(
-			list->textfield,
-			std::to_string(int(std::floor(time_diff / 60.0))) + " Min.",
-		  FontRenderer::Right | FontRenderer::Middle,
-			{ r, 0, 0, 255 }
-		);
+		{
+			Uint8 const r = 160 + 95 * sin(4.0 * total_time);
+			departure_imminent = true;
+
+			// pulses in size with the color
+			rendering::fonts.scalable().render_scaledf(
+				list->textfield,
+				rendering::small_font->height() * float(1.0 + 0.08 * sin(4.0 * total_time)),
+			  FontRenderer::Right | FontRenderer::Middle,
+				{ r, 0, 0, 255 },
+				"%d Min.", minutes
+			);
+		}
+		else
+		{
+			rendering::small_font->renderf(
+				list->textfield,
+			  FontRenderer::Right | FontRenderer::Middle,
+				{ 0, 0, 0, 255 },
+				"%d Min.", minutes
+			);
+		}
 
 		list->advance();
 		list->counter++;
 	}
 }
+
+double tramview::next_frame()
+{
+	if(departure_imminent)
+		return 0.0; // pulsing departure time
+
+	// the minute counters run down
+	return 1.0;
+}
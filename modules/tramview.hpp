@@ -2,6 +2,7 @@
 #define TRAMVIEW_HPP
 
 #include "gui_module.hpp"
+#include "sprite.hpp"
 
 //!
 //! Shows the next four connections of
@@ -11,11 +12,19 @@ struct tramview : gui_module
 {
 	SDL_Texture * background;
 
-	std::array<SDL_Texture*, 8> route_icons;
+	std::array<sprite, 8> route_icons;
+
+	bool departure_imminent = false;
 
 	void init() override;
 
+	void update() override;
+
+	void data_changed() override;
+
 	void render() override;
+
+	double next_frame() override;
 };
 
 #endif // TRAMVIEW_HPP
@@ -0,0 +1,107 @@
+#include "render_context.hpp"
+#include "kiosk.hpp"
+
+namespace
+{
+	bool operator ==(SDL_Color const & a, SDL_Color const & b)
+	{
+		return (a.r == b.r) and (a.g == b.g) and (a.b == b.b) and (a.a == b.a);
+	}
+
+	bool operator ==(SDL_Rect const & a, SDL_Rect const & b)
+	{
+		return (a.x == b.x) and (a.y == b.y) and (a.w == b.w) and (a.h == b.h);
+	}
+}
+
+bool render_context::changed(bool differs)
+{
+	if(differs)
+		stats.issued += 1;
+	else
+		stats.saved += 1;
+	return differs;
+}
+
+void render_context::set_draw_color(SDL_Color const & color)
+{
+	if(not changed(not draw_color or not (*draw_color == color)))
+		return;
+	draw_color = color;
+	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+}
+
+void render_context::set_draw_blend_mode(SDL_BlendMode mode)
+{
+	if(not changed(draw_blend_mode != mode))
+		return;
+	draw_blend_mode = mode;
+	SDL_SetRenderDrawBlendMode(renderer, mode);
+}
+
+void render_context::set_clip_rect(SDL_Rect const * rect)
+{
+	std::optional<SDL_Rect> const value = rect ? std::optional<SDL_Rect> { *rect } : std::nullopt;
+
+	bool differs = not clip_rect or (clip_rect->has_value() != value.has_value());
+	if(not differs and value)
+		differs = not (**clip_rect == *value);
+
+	if(not changed(differs))
+		return;
+	clip_rect = value;
+	SDL_RenderSetClipRect(renderer, rect);
+}
+
+void render_context::set_target(SDL_Texture * texture)
+{
+	if(not changed(target != texture))
+		return;
+	target = texture;
+	clip_rect.reset();
+	SDL_SetRenderTarget(renderer, texture);
+}
+
+void render_context::set_texture_blend_mode(SDL_Texture * texture, SDL_BlendMode mode)
+{
+	auto & state = textures[texture];
+	if(not changed(state.blend_mode != mode))
+		return;
+	state.blend_mode = mode;
+	SDL_SetTextureBlendMode(texture, mode);
+}
+
+void render_context::set_texture_color_mod(SDL_Texture * texture, Uint8 r, Uint8 g, Uint8 b)
+{
+	SDL_Color const color = { r, g, b, 0xFF };
+	auto & state = textures[texture];
+	if(not changed(not state.color_mod or not (*state.color_mod == color)))
+		return;
+	state.color_mod = color;
+	SDL_SetTextureColorMod(texture, r, g, b);
+}
+
+void render_context::set_texture_alpha_mod(SDL_Texture * texture, Uint8 alpha)
+{
+	auto & state = textures[texture];
+	if(not changed(state.alpha_mod != alpha))
+		return;
+	state.alpha_mod = alpha;
+	SDL_SetTextureAlphaMod(texture, alpha);
+}
+
+void render_context::forget(SDL_Texture * texture)
+{
+	textures.erase(texture);
+	if(target == texture)
+		target.reset();
+}
+
+void render_context::reset()
+{
+	draw_color.reset();
+	draw_blend_mode.reset();
+	clip_rect.reset();
+	target.reset();
+	textures.clear();
+}
@@ -0,0 +1,64 @@
+#ifndef RENDER_CONTEXT_HPP
+#define RENDER_CONTEXT_HPP
+
+#include <SDL.h>
+#include <optional>
+#include <unordered_map>
+
+//!
+//! Thin wrapper around the state of the SDL renderer.
+//! Remembers the last value of each state and skips
+//! the SDL call if it would not change anything.
+//!
+struct render_context
+{
+	struct statistics
+	{
+		size_t issued = 0; //!< calls passed to SDL
+		size_t saved = 0;  //!< calls skipped, because nothing changed
+	};
+
+	statistics stats;
+
+	void set_draw_color(SDL_Color const & color);
+
+	void set_draw_blend_mode(SDL_BlendMode mode);
+
+	//! nullptr disables clipping.
+	void set_clip_rect(SDL_Rect const * rect);
+
+	//! nullptr selects the window. Forgets the clip rect,
+	//! as SDL keeps a separate one per target.
+	void set_target(SDL_Texture * target);
+
+	void set_texture_blend_mode(SDL_Texture * texture, SDL_BlendMode mode);
+
+	void set_texture_color_mod(SDL_Texture * texture, Uint8 r, Uint8 g, Uint8 b);
+
+	void set_texture_alpha_mod(SDL_Texture * texture, Uint8 alpha);
+
+	//! must be called before a texture with cached state is destroyed.
+	void forget(SDL_Texture * texture);
+
+	//! forgets all cached state, e.g. after the render device was reset.
+	void reset();
+
+private:
+	struct texture_state
+	{
+		std::optional<SDL_BlendMode> blend_mode;
+		std::optional<SDL_Color> color_mod; // alpha is the alpha mod
+		std::optional<Uint8> alpha_mod;
+	};
+
+	std::optional<SDL_Color> draw_color;
+	std::optional<SDL_BlendMode> draw_blend_mode;
+	std::optional<std::optional<SDL_Rect>> clip_rect; // outer: known, inner: enabled
+	std::optional<SDL_Texture*> target;
+	std::unordered_map<SDL_Texture*, texture_state> textures;
+
+	//! returns true if the SDL call has to be made and counts it.
+	bool changed(bool differs);
+};
+
+#endif // RENDER_CONTEXT_HPP
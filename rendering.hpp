@@ -2,13 +2,22 @@
 #define RENDERING_HPP
 
 #include "fontrenderer.hpp"
-#include <optional>
+#include "font_manager.hpp"
+#include "batch_renderer.hpp"
+#include "render_context.hpp"
+#include "glyph_atlas.hpp"
 
 namespace rendering
 {
-	inline std::optional<FontRenderer> big_font;
-	inline std::optional<FontRenderer> medium_font;
-	inline std::optional<FontRenderer> small_font;
+	inline render_context context;
+	inline batch_renderer batch;
+	inline glyph_atlas atlas;
+
+	inline font_manager fonts;
+
+	inline FontRenderer * big_font = nullptr;
+	inline FontRenderer * medium_font = nullptr;
+	inline FontRenderer * small_font = nullptr;
 }
 
 #endif // RENDERING_HPP
@@ -0,0 +1,119 @@
+#include "resource_bundle.hpp"
+#include "icon_atlas.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	//! true if `file` still has the size and modification time it had when packed
+	bool unchanged(std::filesystem::path const & file, resource_bundle::entry const & e)
+	{
+		struct stat info;
+		if(stat(file.c_str(), &info) < 0)
+			return false;
+		Sint64 const mtime = Sint64(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+		return Uint64(info.st_size) == e.source_size and mtime == e.source_mtime;
+	}
+}
+
+bool resource_bundle::open(std::filesystem::path const & file)
+{
+	close();
+
+	int const fd = ::open(file.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false; // no bundle, load the PNG files
+
+	struct stat info;
+	if(fstat(fd, &info) < 0 or size_t(info.st_size) < sizeof(header))
+	{
+		::close(fd);
+		return false;
+	}
+
+	void * const mapping = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if(mapping == MAP_FAILED)
+	{
+		fprintf(stderr, "failed to map resource bundle %s: %s\n", file.c_str(), strerror(errno));
+		return false;
+	}
+	data = mapping;
+	length = size_t(info.st_size);
+
+	auto const * const bytes = static_cast<char const *>(data);
+	auto const * const head = static_cast<header const *>(data);
+
+	size_t const entries_end = sizeof(header) + sizeof(entry) * size_t(head->count);
+	bool valid = std::memcmp(head->magic, magic, sizeof magic) == 0
+		and head->version == version
+		and head->atlas_hash == icon_atlas::hash
+		and entries_end + head->names_size <= length;
+
+	auto const root = file.parent_path();
+	auto const * const entries = reinterpret_cast<entry const *>(bytes + sizeof(header));
+	char const * const names = bytes + entries_end;
+	for(Uint32 i = 0; valid and i < head->count; i++)
+	{
+		auto const & e = entries[i];
+		image const img {
+			e.w, e.h, e.pitch,
+			(e.flags & flag_alpha) != 0,
+			bytes + e.pixels_offset,
+		};
+		valid = e.format == format
+			and size_t(e.name_offset) + e.name_length <= head->names_size
+			and e.w > 0 and e.h > 0 and e.pitch >= 4 * e.w
+			and e.pixels_offset + img.bytes() <= length;
+		if(not valid)
+			break;
+
+		std::string const name(names + e.name_offset, e.name_length);
+		if(unchanged(root / name, e))
+			images.emplace(name, img);
+		else
+			fprintf(stderr, "%s changed since the resource bundle was packed, loading the PNG file\n", name.c_str());
+	}
+
+	if(not valid)
+	{
+		fprintf(stderr, "resource bundle %s is invalid or outdated, loading PNG files\n", file.c_str());
+		close();
+		return false;
+	}
+	return true;
+}
+
+void resource_bundle::close()
+{
+	images.clear();
+	if(data != nullptr)
+		munmap(const_cast<void *>(data), length);
+	data = nullptr;
+	length = 0;
+}
+
+resource_bundle::image const * resource_bundle::find(std::filesystem::path const & path) const
+{
+	auto const it = images.find(path);
+	if(it == images.end())
+		return nullptr;
+	return &it->second;
+}
+
+void resource_bundle::prefetch(image const & img) const
+{
+	// madvise wants a page aligned start
+	auto const page = uintptr_t(sysconf(_SC_PAGESIZE));
+	auto const start = uintptr_t(img.pixels) & ~(page - 1);
+	auto const end = uintptr_t(img.pixels) + img.bytes();
+	madvise(reinterpret_cast<void *>(start), end - start, MADV_WILLNEED);
+}
@@ -0,0 +1,80 @@
+#ifndef RESOURCE_BUNDLE_HPP
+#define RESOURCE_BUNDLE_HPP
+
+#include <SDL.h>
+#include <filesystem>
+#include <map>
+
+//!
+//! All images of the resource folder in one file, already decoded
+//! into the texture format of the renderer. The file is mapped into
+//! memory and textures are uploaded straight from the mapping, so
+//! loading an image costs neither file reads nor PNG decoding.
+//!
+//! The bundle is built by tools/pack_bundle.cpp (`make bundle`). It
+//! remembers the size and modification time of every PNG file and the
+//! icon atlas it was packed for, so a PNG edited afterwards is loaded
+//! from its file and a bundle of another atlas is not used at all.
+//!
+struct resource_bundle
+{
+	//! layout of the bundle file:
+	//! header, `count` entries, names, then the pixels of each entry
+	struct header
+	{
+		char magic[4];
+		Uint32 version;
+		Uint32 count;
+		Uint32 names_size;
+		Uint64 atlas_hash; // icon_atlas::hash
+	};
+
+	struct entry
+	{
+		Uint32 name_offset, name_length; // path relative to the resource root
+		Sint32 w, h, pitch;
+		Uint32 format;
+		Uint32 flags;
+		Uint32 reserved;
+		Uint64 pixels_offset;
+		Uint64 source_size;  // of the PNG file
+		Sint64 source_mtime; // of the PNG file, in nanoseconds
+	};
+
+	static constexpr char magic[4] = { 'K', 'R', 'E', 'S' };
+	static constexpr Uint32 version = 2;
+	static constexpr Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+	static constexpr Uint32 flag_alpha = 1; // has translucent pixels
+	static constexpr size_t alignment = 64; // of the pixel data
+
+	struct image
+	{
+		int w, h, pitch;
+		bool alpha;
+		void const * pixels;
+
+		size_t bytes() const { return size_t(pitch) * size_t(h); }
+	};
+
+	//! maps the bundle, which lies in the resource root. Returns false if
+	//! it doesn't exist, is invalid or outdated, then every image is loaded
+	//! from its PNG file. Images whose PNG file changed are left out.
+	bool open(std::filesystem::path const & file);
+
+	void close();
+
+	//! returns the image at `path` relative to the resource root or nullptr.
+	image const * find(std::filesystem::path const & path) const;
+
+	//! lets the kernel read the pixels of `img` in the background.
+	void prefetch(image const & img) const;
+
+	~resource_bundle() { close(); }
+
+private:
+	void const * data = nullptr;
+	size_t length = 0;
+	std::map<std::filesystem::path, image> images;
+};
+
+#endif // RESOURCE_BUNDLE_HPP
@@ -0,0 +1,8 @@
+#include "sprite.hpp"
+#include "asset_manager.hpp"
+
+sprite get_icon(icon_atlas::icon id)
+{
+	static SDL_Texture * const atlas = assets.acquire(nullptr, icon_atlas::file);
+	return sprite { atlas, icon_atlas::rects[id] };
+}
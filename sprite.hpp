@@ -0,0 +1,32 @@
+#ifndef SPRITE_HPP
+#define SPRITE_HPP
+
+#include "icon_atlas.hpp"
+
+#include <SDL.h>
+
+//! A rectangle of a texture, drawn like a texture of its own.
+//! All icons share one atlas texture, so drawing any number of them
+//! needs no texture switch.
+struct sprite
+{
+	SDL_Texture * texture = nullptr;
+	SDL_Rect src = { 0, 0, 0, 0 };
+
+	explicit operator bool() const { return texture != nullptr; }
+
+	bool operator==(sprite const & other) const
+	{
+		return texture == other.texture
+			and src.x == other.src.x and src.y == other.src.y
+			and src.w == other.src.w and src.h == other.src.h;
+	}
+
+	bool operator!=(sprite const & other) const { return not (*this == other); }
+};
+
+//! returns the icon from the icon atlas.
+//! The atlas texture is loaded on first use and kept as long as the kiosk runs.
+sprite get_icon(icon_atlas::icon id);
+
+#endif // SPRITE_HPP
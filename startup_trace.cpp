@@ -0,0 +1,170 @@
+#include "startup_trace.hpp"
+#include "kiosk.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <cxxabi.h>
+
+startup_trace trace;
+
+namespace
+{
+	size_t constexpr summary_length = 10; // slowest spans that are printed
+
+	char constexpr mark_category[] = "mark";
+
+	std::string demangle(char const * name)
+	{
+		int status;
+		char * const demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+		if(demangled == nullptr)
+			return name;
+		std::string result = demangled;
+		free(demangled);
+		return result;
+	}
+}
+
+startup_trace::span::span(char const * category, std::string name) :
+	category(category),
+	name(std::move(name)),
+	start(clock::now())
+{
+}
+
+startup_trace::span::span(char const * category, std::type_info const & type) :
+	span(category, trace.finished() ? std::string() : demangle(type.name()))
+{
+}
+
+startup_trace::span::~span()
+{
+	trace.add(category, std::move(name), start, clock::now());
+}
+
+void startup_trace::add(char const * category, std::string name, clock::time_point start, clock::time_point end)
+{
+	if(done)
+		return;
+
+	using seconds = std::chrono::duration<double>;
+	std::lock_guard<std::mutex> _ { lock };
+	if(done)
+		return; // finish() took the lock first and is reading the records
+
+	records.push_back(record {
+		category,
+		std::move(name),
+		seconds(start - origin).count(),
+		seconds(end - start).count(),
+		std::this_thread::get_id(),
+	});
+}
+
+void startup_trace::mark(char const * name)
+{
+	auto const now = clock::now();
+	add(mark_category, name, now, now);
+}
+
+void startup_trace::finish()
+{
+	if(done)
+		return;
+
+	auto const total = std::chrono::duration<double>(clock::now() - origin).count();
+	{
+		// spans being added complete first, later ones see `done` under
+		// the lock and are dropped, so the records stay unchanged from here
+		std::lock_guard<std::mutex> _ { lock };
+		done = true;
+	}
+
+	print_summary(total);
+
+	std::filesystem::path file;
+	if(char const * env = getenv("KIOSK_STARTUP_REPORT"); env != nullptr and *env != 0)
+		file = env;
+	else if(auto const dir = cache_directory(); not dir.empty())
+		file = dir / "startup.json";
+	if(not file.empty())
+		write_report(file, total);
+}
+
+bool startup_trace::is_mark(record const & r)
+{
+	return r.category == mark_category;
+}
+
+void startup_trace::print_summary(double total) const
+{
+	std::map<std::string, double> categories;
+	for(auto const & r : records)
+	{
+		if(not is_mark(r))
+			categories[r.category] += r.duration;
+	}
+
+	fprintf(stdout, "Startup took %.1f ms\n", 1000.0 * total);
+	for(auto const & r : records)
+	{
+		if(is_mark(r))
+			fprintf(stdout, "  %8.1f ms  %s\n", 1000.0 * r.start, r.name.c_str());
+	}
+	for(auto const & [ category, duration ] : categories)
+		fprintf(stdout, "  %-10s %8.1f ms\n", category.c_str(), 1000.0 * duration);
+
+	std::vector<record const *> slowest;
+	for(auto const & r : records)
+	{
+		if(not is_mark(r))
+			slowest.push_back(&r);
+	}
+	std::sort(slowest.begin(), slowest.end(), [](record const * a, record const * b)
+	{
+		return a->duration > b->duration;
+	});
+	slowest.resize(std::min(slowest.size(), summary_length));
+
+	fprintf(stdout, "Slowest:\n");
+	for(auto const * r : slowest)
+		fprintf(stdout, "  %8.1f ms  %s %s\n", 1000.0 * r->duration, r->category, r->name.c_str());
+	fflush(stdout);
+}
+
+void startup_trace::write_report(std::filesystem::path const & file, double total) const
+{
+	// threads are numbered in the order they first appear, the main thread is 0
+	std::map<std::thread::id, int> threads;
+	nlohmann::json spans = nlohmann::json::array();
+	for(auto const & r : records)
+	{
+		auto const thread = threads.emplace(r.thread, int(threads.size())).first->second;
+		spans.push_back({
+			{ "category", r.category },
+			{ "name", r.name },
+			{ "start", r.start },
+			{ "duration", r.duration },
+			{ "thread", thread },
+		});
+	}
+
+	nlohmann::json const report = {
+		{ "build", __DATE__ " " __TIME__ },
+		{ "total", total },
+		{ "spans", std::move(spans) },
+	};
+
+	std::error_code error;
+	std::filesystem::create_directories(file.parent_path(), error);
+
+	std::ofstream out(file);
+	out << report.dump(1, '\t') << "\n";
+	if(not out)
+		fprintf(stderr, "failed to write startup report %s\n", file.c_str());
+}
@@ -0,0 +1,81 @@
+#ifndef STARTUP_TRACE_HPP
+#define STARTUP_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+//!
+//! Records how long each phase of the startup takes, from the
+//! initialization of SDL to the last module that is preloaded.
+//!
+//! When the startup is finished, a summary is printed and a JSON
+//! report is written to $KIOSK_STARTUP_REPORT or to startup.json
+//! in the cache directory, so the startup of different builds can
+//! be compared.
+//!
+struct startup_trace
+{
+	using clock = std::chrono::steady_clock;
+
+	//! measures the time from its construction to its destruction.
+	//! May be used on any thread.
+	struct span
+	{
+		span(char const * category, std::string name);
+
+		//! names the span after a type, e.g. a module
+		span(char const * category, std::type_info const & type);
+
+		span(span const &) = delete;
+		span & operator=(span const &) = delete;
+
+		~span();
+
+	private:
+		char const * category;
+		std::string name;
+		clock::time_point start;
+	};
+
+	//! records an instant, e.g. the first frame.
+	void mark(char const * name);
+
+	//! prints the summary and writes the report.
+	//! Spans that end later are ignored.
+	void finish();
+
+	bool finished() const { return done; }
+
+private:
+	struct record
+	{
+		char const * category;
+		std::string name;
+		double start; // seconds since the process started
+		double duration;
+		std::thread::id thread;
+	};
+
+	clock::time_point const origin = clock::now();
+	std::atomic_bool done { false };
+	std::mutex lock;
+	std::vector<record> records;
+
+	void add(char const * category, std::string name, clock::time_point start, clock::time_point end);
+
+	static bool is_mark(record const & r);
+
+	void print_summary(double total) const;
+
+	void write_report(std::filesystem::path const & file, double total) const;
+};
+
+extern startup_trace trace;
+
+#endif // STARTUP_TRACE_HPP
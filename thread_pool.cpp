@@ -0,0 +1,40 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+thread_pool::thread_pool(size_t threads)
+{
+	if(threads == 0)
+		threads = std::max(1U, std::thread::hardware_concurrency());
+	for(size_t i = 0; i < threads; i++)
+		workers.emplace_back(&thread_pool::run, this);
+}
+
+thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock { mutex };
+		stop = true;
+	}
+	wakeup.notify_all();
+	for(auto & worker : workers)
+		worker.join();
+}
+
+void thread_pool::run()
+{
+	std::unique_lock<std::mutex> lock { mutex };
+	while(true)
+	{
+		wakeup.wait(lock, [this] { return stop or not jobs.empty(); });
+		if(stop)
+			return;
+
+		auto job = std::move(jobs.front());
+		jobs.pop_front();
+
+		lock.unlock();
+		job();
+		lock.lock();
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//!
+//! A fixed set of worker threads that run submitted jobs
+//! in the order they were submitted.
+//!
+struct thread_pool
+{
+	//! starts one worker per hardware thread by default.
+	explicit thread_pool(size_t threads = 0);
+
+	//! waits for the running jobs, queued jobs are dropped.
+	~thread_pool();
+
+	thread_pool(thread_pool const &) = delete;
+	thread_pool & operator=(thread_pool const &) = delete;
+
+	//! runs `job` on a worker and returns its result as a future.
+	template<typename F>
+	auto submit(F && job) -> std::future<decltype(job())>
+	{
+		using result = decltype(job());
+		auto task = std::make_shared<std::packaged_task<result()>>(std::forward<F>(job));
+		auto future = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock { mutex };
+			jobs.emplace_back([task] { (*task)(); });
+		}
+		wakeup.notify_one();
+		return future;
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	std::deque<std::function<void()>> jobs;
+	bool stop = false;
+	std::vector<std::thread> workers;
+
+	void run();
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,172 @@
+// Build step: decodes every PNG below the resource folder and writes
+// them into one resource bundle, see resource_bundle.hpp.
+//
+// usage: pack_bundle <resource-dir> <output-bundle>
+//
+// Needs the generated icon_atlas.hpp in the include path, the bundle is
+// only used by a kiosk built with the same one.
+
+#include "../resource_bundle.hpp"
+#include "icon_atlas.hpp"
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+struct image
+{
+	std::string name;
+	SDL_Surface * surface;
+	bool alpha;
+	struct stat source;
+};
+
+[[noreturn]] static void die(char const * msg, char const * detail)
+{
+	fprintf(stderr, "pack_bundle: %s: %s\n", msg, detail);
+	exit(EXIT_FAILURE);
+}
+
+static bool has_alpha(SDL_Surface const * surface)
+{
+	for(int y = 0; y < surface->h; y++)
+	{
+		auto const * row = reinterpret_cast<Uint32 const *>(static_cast<char const *>(surface->pixels) + y * surface->pitch);
+		for(int x = 0; x < surface->w; x++)
+		{
+			if((row[x] >> 24) != 0xFF)
+				return true;
+		}
+	}
+	return false;
+}
+
+static size_t align(size_t offset)
+{
+	return (offset + resource_bundle::alignment - 1) & ~(resource_bundle::alignment - 1);
+}
+
+int main(int argc, char ** argv)
+{
+	if(argc != 3)
+	{
+		fprintf(stderr, "usage: %s <resource-dir> <output-bundle>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	fs::path const resources = argv[1];
+	fs::path const output = argv[2];
+
+	if(IMG_Init(IMG_INIT_PNG) != IMG_INIT_PNG)
+		die("could not initialize SDL_image", IMG_GetError());
+
+	std::vector<fs::path> files;
+	for(auto const & entry : fs::recursive_directory_iterator(resources))
+	{
+		if(entry.is_regular_file() and entry.path().extension() == ".png")
+			files.push_back(entry.path());
+	}
+	std::sort(files.begin(), files.end());
+
+	std::vector<image> images;
+	std::string names;
+	for(auto const & file : files)
+	{
+		struct stat source;
+		if(stat(file.c_str(), &source) < 0)
+			die(file.c_str(), strerror(errno));
+
+		SDL_Surface * loaded = IMG_Load(file.c_str());
+		if(loaded == nullptr)
+			die(file.c_str(), IMG_GetError());
+
+		SDL_Surface * surface = SDL_ConvertSurfaceFormat(loaded, resource_bundle::format, 0);
+		SDL_FreeSurface(loaded);
+		if(surface == nullptr)
+			die(file.c_str(), SDL_GetError());
+
+		images.push_back(image { fs::relative(file, resources).generic_string(), surface, has_alpha(surface), source });
+	}
+
+	std::vector<resource_bundle::entry> entries;
+	size_t offset = sizeof(resource_bundle::header) + images.size() * sizeof(resource_bundle::entry);
+	for(auto const & i : images)
+	{
+		resource_bundle::entry e;
+		std::memset(&e, 0, sizeof e);
+		e.name_offset = Uint32(names.size());
+		e.name_length = Uint32(i.name.size());
+		e.w = i.surface->w;
+		e.h = i.surface->h;
+		e.pitch = i.surface->pitch;
+		e.format = resource_bundle::format;
+		e.flags = i.alpha ? resource_bundle::flag_alpha : 0;
+		e.source_size = Uint64(i.source.st_size);
+		e.source_mtime = Sint64(i.source.st_mtim.tv_sec) * 1000000000 + i.source.st_mtim.tv_nsec;
+		entries.push_back(e);
+		names += i.name;
+	}
+	offset += names.size();
+	for(size_t k = 0; k < images.size(); k++)
+	{
+		offset = align(offset);
+		entries[k].pixels_offset = offset;
+		offset += size_t(entries[k].pitch) * size_t(entries[k].h);
+	}
+
+	// write to a temporary file, so a running kiosk never maps a half written bundle
+	auto const temp = fs::path(output).concat(".tmp");
+	FILE * const f = fopen(temp.c_str(), "wb");
+	if(f == nullptr)
+		die(temp.c_str(), strerror(errno));
+
+	resource_bundle::header header;
+	std::memcpy(header.magic, resource_bundle::magic, sizeof header.magic);
+	header.version = resource_bundle::version;
+	header.count = Uint32(entries.size());
+	header.names_size = Uint32(names.size());
+	header.atlas_hash = icon_atlas::hash;
+
+	bool ok = (fwrite(&header, sizeof header, 1, f) == 1);
+	ok = ok and (fwrite(entries.data(), sizeof(resource_bundle::entry), entries.size(), f) == entries.size());
+	ok = ok and (fwrite(names.data(), 1, names.size(), f) == names.size());
+
+	char const zeroes[resource_bundle::alignment] = { };
+	for(size_t k = 0; ok and k < images.size(); k++)
+	{
+		size_t const gap = entries[k].pixels_offset - size_t(ftell(f));
+		ok = ok and (fwrite(zeroes, 1, gap, f) == gap);
+
+		auto const * surface = images[k].surface;
+		size_t const bytes = size_t(surface->pitch) * size_t(surface->h);
+		ok = ok and (fwrite(surface->pixels, 1, bytes, f) == bytes);
+	}
+	ok = (fclose(f) == 0) and ok;
+
+	std::error_code error;
+	if(ok)
+		fs::rename(temp, output, error);
+	if(not ok or error)
+	{
+		fs::remove(temp, error);
+		die(output.c_str(), "could not write the bundle");
+	}
+
+	for(auto & i : images)
+		SDL_FreeSurface(i.surface);
+	IMG_Quit();
+
+	printf("packed %zu images into %s (%zu bytes)\n", images.size(), output.c_str(), offset);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+// Build step: packs the small images from resources/icons and
+// resources/tram into a single atlas image and emits a header with the
+// source rectangle of every icon.
+//
+// usage: pack_icons <resource-dir> <output-header>
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+namespace fs = std::filesystem;
+
+//! width of the atlas, the height is the next power of two that fits
+int constexpr atlas_width = 2048;
+
+//! transparent gap around every icon, so linear filtering of a scaled
+//! icon never picks up its neighbours
+int constexpr padding = 2;
+
+//! larger images (backgrounds) stay separate textures
+int constexpr max_icon_size = 512;
+
+char constexpr atlas_file[] = "icon_atlas.png";
+
+struct icon
+{
+	std::string name;
+	SDL_Surface * surface;
+	SDL_Rect rect;
+};
+
+//! FNV-1a of the icon names and rectangles, lets the resource bundle
+//! recognize that it was packed for a different atlas
+static Uint64 layout_hash(std::vector<icon> const & icons)
+{
+	Uint64 hash = 0xcbf29ce484222325ull;
+	auto const add = [&](std::string const & text)
+	{
+		for(unsigned char c : text)
+			hash = (hash ^ c) * 0x100000001b3ull;
+	};
+	for(auto const & i : icons)
+	{
+		add(i.name);
+		add(" " + std::to_string(i.rect.x) + " " + std::to_string(i.rect.y)
+		  + " " + std::to_string(i.rect.w) + " " + std::to_string(i.rect.h) + "\n");
+	}
+	return hash;
+}
+
+[[noreturn]] static void die(char const * msg, char const * detail)
+{
+	fprintf(stderr, "pack_icons: %s: %s\n", msg, detail);
+	exit(EXIT_FAILURE);
+}
+
+//! turns "magnify-plus-outline.png" into "magnify_plus_outline"
+static std::string identifier(std::string const & prefix, fs::path const & file)
+{
+	std::string name = prefix + file.stem().string();
+	for(auto & c : name)
+	{
+		if(not isalnum(static_cast<unsigned char>(c)))
+			c = '_';
+	}
+	if(isdigit(static_cast<unsigned char>(name.front())))
+		name.insert(name.begin(), '_');
+	return name;
+}
+
+static void collect(std::vector<icon> & icons, fs::path const & dir, std::string const & prefix)
+{
+	std::vector<fs::path> files;
+	for(auto const & entry : fs::directory_iterator(dir))
+	{
+		if(entry.is_regular_file() and entry.path().extension() == ".png")
+			files.push_back(entry.path());
+	}
+	std::sort(files.begin(), files.end());
+
+	for(auto const & file : files)
+	{
+		SDL_Surface * loaded = IMG_Load(file.c_str());
+		if(loaded == nullptr)
+			die(file.c_str(), IMG_GetError());
+
+		if(loaded->w > max_icon_size or loaded->h > max_icon_size)
+		{
+			SDL_FreeSurface(loaded);
+			continue;
+		}
+
+		SDL_Surface * surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(loaded);
+		if(surface == nullptr)
+			die(file.c_str(), SDL_GetError());
+
+		icons.push_back(icon { identifier(prefix, file), surface, { 0, 0, surface->w, surface->h } });
+	}
+}
+
+//! shelf packing, tallest first. returns the used height.
+static int pack(std::vector<icon> & icons)
+{
+	std::vector<icon *> order;
+	for(auto & i : icons)
+		order.push_back(&i);
+	std::stable_sort(order.begin(), order.end(), [](icon const * a, icon const * b)
+	{
+		return a->rect.h > b->rect.h;
+	});
+
+	int x = 0, y = 0, shelf_height = 0;
+	for(auto * i : order)
+	{
+		int const w = i->rect.w + 2 * padding;
+		int const h = i->rect.h + 2 * padding;
+		if(x + w > atlas_width)
+		{
+			x = 0;
+			y += shelf_height;
+			shelf_height = 0;
+		}
+		i->rect.x = x + padding;
+		i->rect.y = y + padding;
+		x += w;
+		shelf_height = std::max(shelf_height, h);
+	}
+	return y + shelf_height;
+}
+
+int main(int argc, char ** argv)
+{
+	if(argc != 3)
+	{
+		fprintf(stderr, "usage: %s <resource-dir> <output-header>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	fs::path const resources = argv[1];
+	fs::path const header = argv[2];
+
+	if(IMG_Init(IMG_INIT_PNG) != IMG_INIT_PNG)
+		die("could not initialize SDL_image", IMG_GetError());
+
+	std::vector<icon> icons;
+	collect(icons, resources / "icons", "");
+	collect(icons, resources / "tram", "tram_");
+
+	int const used_height = pack(icons);
+	int height = 1;
+	while(height < used_height)
+		height *= 2;
+
+	SDL_Surface * atlas = SDL_CreateRGBSurfaceWithFormat(0, atlas_width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+	if(atlas == nullptr)
+		die("could not create atlas", SDL_GetError());
+
+	for(auto & i : icons)
+	{
+		SDL_SetSurfaceBlendMode(i.surface, SDL_BLENDMODE_NONE);
+		SDL_BlitSurface(i.surface, nullptr, atlas, &i.rect);
+		SDL_FreeSurface(i.surface);
+	}
+
+	auto const image = resources / atlas_file;
+	if(IMG_SavePNG(atlas, image.c_str()) != 0)
+		die(image.c_str(), IMG_GetError());
+	SDL_FreeSurface(atlas);
+
+	std::ofstream out(header);
+	if(not out)
+		die(header.c_str(), "could not open for writing");
+
+	out << "// generated by tools/pack_icons.cpp, do not edit\n"
+	    << "#ifndef ICON_ATLAS_HPP\n"
+	    << "#define ICON_ATLAS_HPP\n"
+	    << "\n"
+	    << "#include <SDL.h>\n"
+	    << "\n"
+	    << "namespace icon_atlas\n"
+	    << "{\n"
+	    << "\t//! atlas image, relative to the resource root\n"
+	    << "\tchar constexpr file[] = \"" << atlas_file << "\";\n"
+	    << "\n"
+	    << "\t//! changes with every change of the icons or their rectangles\n"
+	    << "\tUint64 constexpr hash = 0x" << std::hex << layout_hash(icons) << std::dec << "ull;\n"
+	    << "\n"
+	    << "\tenum icon\n"
+	    << "\t{\n";
+	for(auto const & i : icons)
+		out << "\t\t" << i.name << ",\n";
+	out << "\t\tcount\n"
+	    << "\t};\n"
+	    << "\n"
+	    << "\t//! source rectangles in the atlas image, indexed by icon\n"
+	    << "\tSDL_Rect constexpr rects[count] =\n"
+	    << "\t{\n";
+	for(auto const & i : icons)
+	{
+		out << "\t\t{ " << i.rect.x << ", " << i.rect.y << ", " << i.rect.w << ", " << i.rect.h << " }, // " << i.name << "\n";
+	}
+	out << "\t};\n"
+	    << "}\n"
+	    << "\n"
+	    << "#endif // ICON_ATLAS_HPP\n";
+
+	IMG_Quit();
+	return out.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,157 @@
+#include "transition.hpp"
+#include "kiosk.hpp"
+#include "mesh.hpp"
+#include "rendering.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+transition::transition(char const * name, double speed) :
+	name(name),
+	speed(speed)
+{
+
+}
+
+transition::~transition()
+{
+
+}
+
+namespace
+{
+	struct alpha_blend : transition
+	{
+		mesh quads;
+
+		alpha_blend() : transition("alpha", 5.0) { }
+
+		void render(SDL_Texture * from, SDL_Texture * to, SDL_Rect const & target, double progress) override
+		{
+			SDL_Rect const src = { 0, 0, target.w, target.h };
+			Uint8 const alpha = Uint8(std::clamp(255.0 * pow(progress, 2.0), 0.0, 255.0));
+
+			rendering::context.set_texture_blend_mode(to, SDL_BLENDMODE_BLEND);
+
+			quads.clear();
+			quads.add_quad(target, src, { target.w, target.h });
+			quads.draw(renderer, from);
+
+			quads.clear();
+			quads.add_quad(target, src, { target.w, target.h }, { 0xFF, 0xFF, 0xFF, alpha });
+			quads.draw(renderer, to);
+		}
+	};
+
+	struct vertical_slider : transition
+	{
+		mesh quads;
+
+		vertical_slider() : transition("slider", 2.0) { }
+
+		void render(SDL_Texture * from, SDL_Texture * to, SDL_Rect const & target, double progress) override
+		{
+			int const pos_y = target.h * glm::smoothstep(0.0, 1.0, progress);
+			SDL_Point const size = { target.w, target.h };
+
+			quads.clear();
+			quads.add_quad(
+				{ target.x, target.y, target.w, pos_y },
+				{ 0, 0, target.w, pos_y },
+				size
+			);
+			quads.draw(renderer, to);
+
+			quads.clear();
+			quads.add_quad(
+				{ target.x, target.y + pos_y, target.w, target.h - pos_y },
+				{ 0, pos_y, target.w, target.h - pos_y },
+				size
+			);
+			quads.draw(renderer, from);
+
+			quads.clear();
+			quads.add_quad(
+				{ target.x, target.y + pos_y - 2, target.w, 5 },
+				{ 0xFF, 0xFF, 0xFF, 0xFF }
+			);
+			quads.draw(renderer, nullptr);
+		}
+	};
+
+	struct pixel_dissolve : transition
+	{
+		static int constexpr columns = 25;
+		static int constexpr rows = 20;
+
+		int threshold[rows][columns];
+
+		mesh from_quads, to_quads;
+
+		pixel_dissolve() : transition("pixels", 4.5)
+		{
+			for(auto & row  : threshold)
+				for(auto & value : row)
+					value = rand() % 64;
+		}
+
+		void render(SDL_Texture * from, SDL_Texture * to, SDL_Rect const & target, double progress) override
+		{
+			int const w = target.w / columns;
+			int const h = target.h / rows;
+			SDL_Point const size = { target.w, target.h };
+
+			int const limit = 64 * progress;
+
+			from_quads.clear();
+			to_quads.clear();
+			for(int x = 0; x < columns; x++)
+			{
+				for(int y = 0; y < rows; y++)
+				{
+					SDL_Rect const src = { w * x, h * y, w, h };
+					SDL_Rect const dst = { target.x + src.x, target.y + src.y, src.w, src.h };
+
+					if(limit > threshold[y][x])
+						to_quads.add_quad(dst, src, size);
+					else
+						from_quads.add_quad(dst, src, size);
+				}
+			}
+			from_quads.draw(renderer, from);
+			to_quads.draw(renderer, to);
+		}
+	};
+
+	std::vector<std::unique_ptr<transition>> & all_transitions()
+	{
+		static std::vector<std::unique_ptr<transition>> list;
+		if(list.empty())
+		{
+			list.emplace_back(std::make_unique<alpha_blend>());
+			list.emplace_back(std::make_unique<vertical_slider>());
+			list.emplace_back(std::make_unique<pixel_dissolve>());
+		}
+		return list;
+	}
+}
+
+transition & transition::get(char const * name)
+{
+	for(auto const & t : all_transitions())
+	{
+		if(strcmp(t->name, name) == 0)
+			return *t;
+	}
+	die("Unknown transition: %s", name);
+}
+
+transition & transition::random()
+{
+	auto const & list = all_transitions();
+	return *list[size_t(rand()) % list.size()];
+}
@@ -0,0 +1,34 @@
+#ifndef TRANSITION_HPP
+#define TRANSITION_HPP
+
+#include <SDL.h>
+
+//!
+//! A visual effect that blends from the outgoing
+//! module to the incoming one.
+//!
+//! New transitions are added by deriving from this
+//! struct and registering them in transition.cpp.
+//!
+struct transition
+{
+	char const * const name;
+
+	//! how fast the transition progresses (per second)
+	double const speed;
+
+	explicit transition(char const * name, double speed);
+	virtual ~transition();
+
+	//! draws the transition into the current render target.
+	//! `from` and `to` are snapshots of both modules, `progress` runs from 0 to 1.
+	virtual void render(SDL_Texture * from, SDL_Texture * to, SDL_Rect const & target, double progress) = 0;
+
+	//! returns the transition with the given name, or aborts.
+	static transition & get(char const * name);
+
+	//! returns a random transition.
+	static transition & random();
+};
+
+#endif // TRANSITION_HPP
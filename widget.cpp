@@ -1,4 +1,5 @@
 #include "widget.hpp"
+#include "rendering.hpp"
 
 widget::~widget()
 {
@@ -12,9 +13,11 @@ notify_result widget::notify(SDL_Event const &)
 
 void widget::render()
 {
-	SDL_SetRenderDrawColor(renderer, 0xFF, 0x00, 0xFF, 0xFF);
-	SDL_RenderFillRect(renderer, &bounds);
+	rendering::batch.fill_rect(bounds, { 0xFF, 0x00, 0xFF, 0xFF });
+	rendering::batch.draw_rect(bounds, { 0xFF, 0xFF, 0xFF, 0xFF });
+}
 
-	SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
-	SDL_RenderDrawRect(renderer, &bounds);
+void widget::invalidate()
+{
+	module::invalidate(bounds);
 }
@@ -6,13 +6,16 @@
 
 struct widget
 {
-	SDL_Rect bounds;
+	SDL_Rect bounds { 0, 0, 0, 0 };
 
 	virtual ~widget();
 
 	virtual notify_result notify(SDL_Event const & ev);
 
 	virtual void render();
+
+	//! marks the widget as changed, so it will be redrawn.
+	void invalidate();
 };
 
 #endif // WIDGET_HPP
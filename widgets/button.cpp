@@ -1,4 +1,5 @@
 #include "button.hpp"
+#include "rendering.hpp"
 
 int constexpr icon_padding = 25;
 int constexpr border_width = 3;
@@ -16,14 +17,14 @@ notify_result button::notify(SDL_Event const & ev)
 
 void button::render()
 {
-	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-	SDL_RenderFillRect(renderer, &bounds);
+	auto & batch = rendering::batch;
+
+	batch.fill_rect(bounds, color);
 
 	SDL_Rect border = bounds;
 	for(int i = 0; i < border_width; i++)
 	{
-		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-		SDL_RenderDrawRect(renderer, &border);
+		batch.draw_rect(border, { 0, 0, 0, 255 });
 		border.x += 1;
 		border.y += 1;
 		border.w -= 2;
@@ -32,10 +33,10 @@ void button::render()
 
 	if(background != nullptr)
 	{
-		SDL_RenderCopy(renderer, background, nullptr, &border);
+		batch.copy(background, nullptr, border);
 	}
 
-	if(icon != nullptr)
+	if(icon)
 	{
 		auto area = bounds;
 		area.x += icon_padding;
@@ -43,8 +44,6 @@ void button::render()
 		area.w -= 2 * icon_padding;
 		area.h -= 2 * icon_padding;
 
-		SDL_SetTextureColorMod(icon, icon_tint.r, icon_tint.g, icon_tint.b);
-		SDL_SetTextureAlphaMod(icon, icon_tint.a);
-		SDL_RenderCopy(renderer, icon, nullptr, &area);
+		batch.copy(icon.texture, &icon.src, area, icon_tint);
 	}
 }
@@ -2,6 +2,7 @@
 #define BUTTON_HPP
 
 #include "widget.hpp"
+#include "sprite.hpp"
 
 #include <functional>
 
@@ -9,7 +10,7 @@ struct button : widget
 {
 	std::function<void()> on_click;
 
-	SDL_Texture * icon = nullptr;
+	sprite icon;
 	SDL_Texture * background = nullptr;
 	SDL_Color icon_tint = { 0x00, 0x00, 0x00, 0xFF };
 	SDL_Color color = { 0x00, 0xBE, 0x00, 0xFF };